@@ -0,0 +1,102 @@
+//compares the collision broadphases on a side-scrolling layout: bodies spread along the x axis,
+//each moving a few pixels per frame. the brute force broadphase is the nested loop Game::update used.
+//build together with broadphase.cpp from platforming_game/ and link SDL3
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "broadphase.h"
+
+namespace {
+    struct moving_body {
+        broadphase_body body;
+        float speed_x;
+        float speed_y;
+    };
+
+    std::vector<moving_body> make_level(size_t body_count) {
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> height(0.0f, 600.0f);
+        std::uniform_real_distribution<float> speed(-3.0f, 3.0f);
+
+        std::vector<moving_body> level;
+        for (size_t i = 0; i < body_count; ++i) {
+            //about one body every 40 pixels, the density of a busy screen
+            SDL_FRect box{ static_cast<float>(i) * 40.0f, height(rng), 30.0f, 30.0f };
+            level.push_back(moving_body{ broadphase_body{ entity_handle{ static_cast<std::uint32_t>(i), 0 }, box }, speed(rng), speed(rng) });
+        }
+        return level;
+    }
+
+    void step(std::vector<moving_body>& level, std::vector<broadphase_body>& bodies) {
+        bodies.clear();
+        for (auto& b : level) {
+            b.body.box.x += b.speed_x;
+            b.body.box.y += b.speed_y;
+            if (b.body.box.y < 0.0f || b.body.box.y > 600.0f) b.speed_y = -b.speed_y;
+            bodies.push_back(b.body);
+        }
+    }
+
+    //average microseconds per frame spent in the broadphase plus the AABB test of every candidate
+    double run(broadphase_type type, size_t body_count, int frames, size_t& overlapping) {
+        broadphase_settings settings;
+        settings.type = type;
+        auto broadphase = make_broadphase(settings);
+
+        auto level = make_level(body_count);
+        std::vector<broadphase_body> bodies;
+        std::vector<SDL_FRect> boxes(body_count);
+
+        double total = 0.0;
+        overlapping = 0;
+
+        for (int frame = 0; frame < frames; ++frame) {
+            step(level, bodies);
+            for (auto& b : bodies) boxes[b.id.index] = b.box;
+
+            auto start = std::chrono::steady_clock::now();
+
+            broadphase->update(bodies);
+
+            size_t hits = 0;
+            for (auto& pair : broadphase->candidate_pairs()) {
+                const SDL_FRect& a = boxes[pair.first.index];
+                const SDL_FRect& b = boxes[pair.second.index];
+                if (a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h) hits++;
+            }
+
+            auto end = std::chrono::steady_clock::now();
+            total += std::chrono::duration<double, std::micro>(end - start).count();
+            overlapping += hits;
+        }
+
+        overlapping /= frames;
+        return total / frames;
+    }
+}
+
+int main() {
+    const size_t body_counts[] = { 100, 1000, 10000 };
+    const int frames = 200;
+
+    std::printf("%8s %16s %16s %16s %10s\n", "bodies", "brute (us)", "grid (us)", "sap (us)", "overlaps");
+
+    for (size_t body_count : body_counts) {
+        size_t overlaps = 0;
+
+        //the nested loop is quadratic, past a few thousand bodies it would take minutes
+        double brute = body_count <= 2000 ? run(broadphase_type::BRUTE_FORCE, body_count, frames, overlaps) : -1.0;
+        double grid = run(broadphase_type::SPATIAL_HASH, body_count, frames, overlaps);
+        double sap = run(broadphase_type::SWEEP_AND_PRUNE, body_count, frames, overlaps);
+
+        if (brute < 0.0) {
+            std::printf("%8zu %16s %16.2f %16.2f %10zu\n", body_count, "skipped", grid, sap, overlaps);
+        }
+        else {
+            std::printf("%8zu %16.2f %16.2f %16.2f %10zu\n", body_count, brute, grid, sap, overlaps);
+        }
+    }
+
+    return 0;
+}
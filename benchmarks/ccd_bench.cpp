@@ -0,0 +1,65 @@
+//fast bodies thrown at a thin wall at several simulation rates, with and without continuous collision.
+//counts the bodies that tunnel through and the collision time per simulated second: with the sweep
+//the lowest rate is as safe as the highest one. build from the root CMakeLists.txt
+//usage: ccd_bench [bodies] [speed]
+#include <cstdio>
+#include <cstdlib>
+#include "simulation.h"
+
+namespace {
+    const float wall_x = 600.0f;
+    const float wall_width = 8.0f;
+
+    struct result {
+        size_t tunneled;
+        double collision_ms; //per simulated second
+    };
+
+    result run(int rate, bool continuous, size_t bodies, double speed) {
+        simulation_settings settings;
+        settings.threads = 1;
+        settings.streaming.enabled = false;
+        settings.collision.continuous = continuous;
+        Simulation simulation(settings);
+
+        simulation.create_platform({ wall_x, -10000.0f, wall_width, 60000.0f }, { 0x00,0xFF,0xFF,0xFF });
+
+        //one body every 40 pixels down the wall, far enough apart to never touch each other, starting
+        //at different distances from the wall so they don't all reach it on the same step
+        for (size_t i = 0; i < bodies; ++i) {
+            double x = -static_cast<double>((i * 37) % 400);
+            entity_handle id = simulation.create_enemy(x, static_cast<double>(i) * 40.0);
+            simulation.em.get_component<components::movement>(id)->speed.x = speed;
+        }
+        simulation.finish_level();
+
+        for (int tick = 0; tick < rate; ++tick) {
+            simulation.step(1.0 / rate);
+        }
+
+        result outcome{ 0, 0.0 };
+        for (auto [id, position, movement] : simulation.em.view<components::position, components::movement>()) {
+            if (position.pos.x > wall_x) outcome.tunneled++;
+        }
+
+        for (size_t i = 0; i < simulation.scheduler.system_count(); ++i) {
+            if (simulation.scheduler.system_name(i) == "collision") outcome.collision_ms = simulation.scheduler.system_total_time(i) * 1000.0;
+        }
+        return outcome;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t bodies = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+    double speed = argc > 2 ? std::atof(argv[2]) : 60.0;
+
+    std::printf("%zu bodies at %.0f px per 1/60 s against a %.0f px wall, one simulated second\n", bodies, speed, wall_width);
+    std::printf("%6s %22s %22s\n", "rate", "discrete: tunneled/ms", "swept: tunneled/ms");
+
+    for (int rate : { 30, 60, 120, 240 }) {
+        result discrete = run(rate, false, bodies, speed);
+        result swept = run(rate, true, bodies, speed);
+        std::printf("%6d %12zu %9.2f %12zu %9.2f\n", rate, discrete.tunneled, discrete.collision_ms, swept.tunneled, swept.collision_ms);
+    }
+    return 0;
+}
@@ -0,0 +1,175 @@
+//headless simulation benchmark: spawns players, enemies and platforms in a Simulation (no window,
+//no renderer), drives the players with a scripted input and reports ticks per second and the time
+//spent in every system. runs on machines without a display.
+//usage: headless_bench [--players N] [--enemies N] [--platforms N] [--ticks M] [--threads T]
+//                      [--broadphase grid|sap|brute] [--storage sparse|archetype] [--streaming on|off]
+//                      [--profile on|off] [--trace file.json] [--trace-ticks first:last]
+//--profile prints min/avg/p99 per profiler marker over the last ticks, --trace writes the markers of
+//the given ticks (all of them by default) as a chrome trace
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "profiler.h"
+#include "simulation.h"
+
+namespace {
+    struct bench_settings {
+        size_t players = 100;
+        size_t enemies = 5000;
+        size_t platforms = 500;
+        unsigned long long ticks = 1200;
+        bool profile = false;
+        std::string trace_path;
+        unsigned long long trace_first = 0;
+        unsigned long long trace_last = ~0ull;
+        simulation_settings simulation;
+    };
+
+    bool parse(int argc, char* argv[], bench_settings& bench) {
+        for (int i = 1; i < argc; ++i) {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "missing value for %s\n", argv[i]);
+                return false;
+            }
+
+            const char* option = argv[i];
+            const char* value = argv[++i];
+
+            if (std::strcmp(option, "--players") == 0) bench.players = std::strtoul(value, nullptr, 10);
+            else if (std::strcmp(option, "--enemies") == 0) bench.enemies = std::strtoul(value, nullptr, 10);
+            else if (std::strcmp(option, "--platforms") == 0) bench.platforms = std::strtoul(value, nullptr, 10);
+            else if (std::strcmp(option, "--ticks") == 0) bench.ticks = std::strtoull(value, nullptr, 10);
+            else if (std::strcmp(option, "--threads") == 0) bench.simulation.threads = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+            else if (std::strcmp(option, "--broadphase") == 0) {
+                if (std::strcmp(value, "sap") == 0) bench.simulation.collision.type = broadphase_type::SWEEP_AND_PRUNE;
+                else if (std::strcmp(value, "brute") == 0) bench.simulation.collision.type = broadphase_type::BRUTE_FORCE;
+                else bench.simulation.collision.type = broadphase_type::SPATIAL_HASH;
+            }
+            else if (std::strcmp(option, "--storage") == 0) {
+                bench.simulation.storage = std::strcmp(value, "archetype") == 0 ? storage_mode::ARCHETYPE : storage_mode::SPARSE_SET;
+            }
+            else if (std::strcmp(option, "--streaming") == 0) bench.simulation.streaming.enabled = std::strcmp(value, "off") != 0;
+            else if (std::strcmp(option, "--profile") == 0) bench.profile = std::strcmp(value, "off") != 0;
+            else if (std::strcmp(option, "--trace") == 0) bench.trace_path = value;
+            else if (std::strcmp(option, "--trace-ticks") == 0) {
+                char* last = nullptr;
+                bench.trace_first = std::strtoull(value, &last, 10);
+                bench.trace_last = *last == ':' ? std::strtoull(last + 1, nullptr, 10) : bench.trace_first;
+            }
+            else {
+                std::fprintf(stderr, "unknown option %s\n", option);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void populate(Simulation& simulation, const bench_settings& bench) {
+        //platforms in a row with gaps to fall through, the death plane below all of them
+        const float platform_width = 300.0f;
+        const float platform_gap = 100.0f;
+        const float level_width = static_cast<float>(bench.platforms) * (platform_width + platform_gap) + platform_width;
+
+        for (size_t i = 0; i < bench.platforms; ++i) {
+            float x = static_cast<float>(i) * (platform_width + platform_gap);
+            float y = 600.0f - static_cast<float>(i % 4) * 60.0f;
+            simulation.create_platform({ x, y, platform_width, 40.0f }, { 0x00,0x00,0xFF,0xFF });
+        }
+
+        simulation.create_death_plane({ -1000.0f, 800.0f, level_width + 2000.0f, 200.0f }, 20);
+
+        for (size_t i = 0; i < bench.players; ++i) {
+            double x = level_width * (static_cast<double>(i) + 0.5) / static_cast<double>(bench.players);
+            simulation.create_player(x, 100.0);
+        }
+
+        for (size_t i = 0; i < bench.enemies; ++i) {
+            double x = level_width * (static_cast<double>(i) + 0.5) / static_cast<double>(bench.enemies);
+            simulation.create_enemy(x, static_cast<double>(i % 10) * 40.0);
+        }
+
+        simulation.finish_level();
+    }
+
+    //every player shares the keyboard: walk right, stop, walk left, and jump every second
+    Input_Script make_script(unsigned long long ticks) {
+        Input_Script script;
+
+        for (unsigned long long tick = 0; tick < ticks; tick += 480) {
+            script.press(tick, SDL_SCANCODE_D);
+            script.release(tick + 180, SDL_SCANCODE_D);
+            script.press(tick + 240, SDL_SCANCODE_A);
+            script.release(tick + 420, SDL_SCANCODE_A);
+        }
+
+        for (unsigned long long tick = 30; tick < ticks; tick += 120) {
+            script.press(tick, SDL_SCANCODE_SPACE);
+            script.release(tick + 20, SDL_SCANCODE_SPACE);
+        }
+
+        return script;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    bench_settings bench;
+    if (!parse(argc, argv, bench)) return 1;
+
+    Simulation simulation(bench.simulation);
+    populate(simulation, bench);
+    simulation.set_script(make_script(bench.ticks));
+
+    std::printf("%zu players, %zu enemies, %zu platforms, %llu ticks, %u threads\n",
+        bench.players, bench.enemies, bench.platforms, bench.ticks, simulation.jobs.size());
+
+    const double step = 1.0 / SIMULATION_RATE;
+
+    //every tick is a profiler frame
+    Profiler& profiler = Profiler::get();
+    profiler.set_enabled(bench.profile || !bench.trace_path.empty());
+    if (!bench.trace_path.empty()) {
+        profiler.capture(bench.trace_first, bench.trace_last);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long long tick = 0; tick < bench.ticks; ++tick) {
+        simulation.step(step);
+        if (Profiler::enabled()) {
+            profiler.end_frame();
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%14.1f ticks/s  %10.3f ms/tick\n", bench.ticks / seconds, seconds * 1000.0 / bench.ticks);
+
+    //systems of a stage run at the same time, so their times can add up to more than the wall time
+    std::printf("%12s %12s %12s %8s\n", "system", "total ms", "ms/tick", "share");
+    for (size_t i = 0; i < simulation.scheduler.system_count(); ++i) {
+        double total = simulation.scheduler.system_total_time(i);
+        std::printf("%12s %12.2f %12.4f %7.1f%%\n", simulation.scheduler.system_name(i).c_str(),
+            total * 1000.0, total * 1000.0 / bench.ticks, 100.0 * total / seconds);
+    }
+
+    if (bench.profile) {
+        std::printf("%24s %10s %10s %10s   (ms per tick, last %d ticks)\n", "marker", "min", "avg", "p99", PROFILER_HISTORY);
+        for (auto& marker : profiler.stats()) {
+            std::printf("%24s %10.4f %10.4f %10.4f\n", marker.name.c_str(), marker.min_ms, marker.avg_ms, marker.p99_ms);
+        }
+    }
+
+    if (!bench.trace_path.empty()) {
+        if (profiler.write_chrome_trace(bench.trace_path)) std::printf("trace written to %s\n", bench.trace_path.c_str());
+        else std::fprintf(stderr, "could not write %s\n", bench.trace_path.c_str());
+    }
+
+    size_t alive = simulation.em.view<components::position>().size();
+    std::printf("entities with a position left: %zu\n", alive);
+
+    const streaming_stats& streaming = simulation.streamer.stats();
+    std::printf("chunks: %zu active, %zu loaded (%zu bytes), %zu unloaded, %zu entities streamed out, worst activation %.3f ms\n",
+        streaming.active_chunks, streaming.loaded_chunks, streaming.resident_bytes, streaming.unloaded_chunks,
+        streaming.streamed_entities, streaming.max_activation_ms);
+    return 0;
+}
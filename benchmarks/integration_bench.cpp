@@ -0,0 +1,91 @@
+//bodies per second through Movement_System::update, one at a time through integrate() against the
+//bulk path bodies without input take: SIMD batches in sparse set storage, a loop over the columns in
+//archetype storage (where the isa makes no difference). every version has to leave the bodies in the same place
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "entity.h"
+#include "movement.h"
+
+namespace {
+    //falling enemies with a few players among them, like the headless benchmark
+    void populate(entity_manager& em, size_t entity_count) {
+        for (size_t i = 0; i < entity_count; ++i) {
+            entity_handle id = em.new_entity();
+            auto* position = em.assign_component<components::position>(id);
+            position->pos = { static_cast<double>(i % 1000) * 10.0, static_cast<double>(i / 1000) * 10.0 };
+
+            auto* collision = em.assign_component<components::collision>(id);
+            collision->hitbox = { static_cast<float>(position->pos.x), static_cast<float>(position->pos.y), 30, 30 };
+
+            auto* movement = em.assign_component<components::movement>(id);
+            movement->speed = { static_cast<double>(i % 7) - 3.0, 0.0 };
+            movement->max_speed = { 15.0, 50.0 };
+            em.assign_component<components::gravity>(id)->falling_strength = 9.8 + static_cast<double>(i % 5);
+
+            if (i % 100 == 1) {
+                em.assign_component<components::input>(id);
+                em.assign_component<components::jump>(id);
+            }
+        }
+    }
+
+    struct result {
+        double bodies_per_second;
+        double checksum; //sum of every coordinate and hitbox corner at the end
+    };
+
+    result run(storage_mode mode, bool bulk, simd_isa isa, size_t entity_count, int iterations) {
+        entity_manager em(mode);
+        Input_Handler input;
+        Collision_System collision(em);
+        Movement_System movement(em, input, collision);
+        movement.set_bulk_integration(bulk, isa);
+
+        populate(em, entity_count);
+        movement.update(1.0 / 120.0); //warm up
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            movement.update(1.0 / 120.0);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        result r;
+        r.bodies_per_second = static_cast<double>(entity_count) * iterations / std::chrono::duration<double>(end - start).count();
+        r.checksum = 0.0;
+        for (auto [id, position, hitbox] : em.view<components::position, components::collision>()) {
+            r.checksum += position.pos.x + position.pos.y + hitbox.hitbox.x + hitbox.hitbox.y;
+        }
+        return r;
+    }
+}
+
+int main() {
+    const size_t entity_counts[] = { 1000, 10000, 100000 };
+    const storage_mode modes[] = { storage_mode::SPARSE_SET, storage_mode::ARCHETYPE };
+    const simd_isa isas[] = { simd_isa::SCALAR, simd_isa::SSE, simd_isa::AVX2 };
+
+    std::printf("best supported: %s\n", simd_isa_name(best_simd_isa()));
+    std::printf("%10s %10s %12s %16s %10s %10s\n", "entities", "storage", "path", "Mbodies/s", "speedup", "same");
+
+    for (storage_mode mode : modes) {
+        for (size_t entity_count : entity_counts) {
+            int iterations = static_cast<int>(4000000 / entity_count);
+            const char* storage = mode == storage_mode::SPARSE_SET ? "sparse" : "archetype";
+
+            result one_by_one = run(mode, false, simd_isa::SCALAR, entity_count, iterations);
+            std::printf("%10zu %10s %12s %16.1f %10s %10s\n", entity_count, storage, "per entity", one_by_one.bodies_per_second / 1e6, "", "");
+
+            for (simd_isa isa : isas) {
+                if (supported_simd_isa(isa) != isa) continue;
+
+                result batched = run(mode, true, isa, entity_count, iterations);
+                std::printf("%10zu %10s %12s %16.1f %9.2fx %10s\n", entity_count, storage, simd_isa_name(isa), batched.bodies_per_second / 1e6,
+                    batched.bodies_per_second / one_by_one.bodies_per_second, batched.checksum == one_by_one.checksum ? "yes" : "NO");
+            }
+        }
+    }
+
+    return 0;
+}
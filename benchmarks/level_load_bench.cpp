@@ -0,0 +1,115 @@
+//time to build a large level three ways: calling the Simulation::create_* functions, parsing the
+//text level format and loading its cooked binary form. build with level_cooker from the root CMakeLists.txt
+//usage: level_load_bench [entity_count]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "level.h"
+#include "simulation.h"
+
+namespace {
+    //a long run of platforms with an enemy standing on every other one, and the player at the start
+    void write_text_level(const std::string& path, size_t entity_count) {
+        std::ofstream file(path);
+        file << "prefab player\n"
+                "    position\n"
+                "    movement acceleration=2,4 max_speed=15,50 max_acceleration=5,5\n"
+                "    render sprite_rect=0,0,50,50 original_width=50 color=0,255,0,255\n"
+                "    gravity\n    input\n    jump\n"
+                "    collision hitbox=0,0,50,50\n"
+                "    health max_health=100 current_health=100 i_frames=5\n"
+                "end\n"
+                "prefab enemy\n"
+                "    position\n"
+                "    render sprite_rect=0,0,30,30\n"
+                "    movement acceleration=5,5 max_speed=100,100 max_acceleration=5,5\n"
+                "    gravity\n"
+                "    collision hitbox=0,0,30,30\n"
+                "    damage damage_amount=5\n"
+                "end\n"
+                "prefab platform\n"
+                "    position\n"
+                "    collision hitbox=0,0,200,40 is_rigid=true\n"
+                "    render sprite_rect=0,0,200,40 original_width=200 color=0,0,255,255\n"
+                "end\n";
+
+        file << "entity player 10 10\n";
+        for (size_t i = 1; i < entity_count; ++i) {
+            double x = static_cast<double>(i / 2) * 250.0;
+            if (i % 2) file << "entity platform " << x << " 600\n";
+            else file << "entity enemy " << x << " 560\n";
+        }
+    }
+
+    void create_level(Simulation& simulation, size_t entity_count) {
+        simulation.create_player(10.0, 10.0);
+        for (size_t i = 1; i < entity_count; ++i) {
+            double x = static_cast<double>(i / 2) * 250.0;
+            if (i % 2) simulation.create_platform({ static_cast<float>(x), 600, 200, 40 }, { 0x00,0x00,0xFF,0xFF });
+            else simulation.create_enemy(x, 560.0);
+        }
+    }
+
+    simulation_settings single_thread(storage_mode storage) {
+        simulation_settings settings;
+        settings.threads = 1;
+        settings.storage = storage;
+        return settings;
+    }
+
+    double milliseconds_since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t entity_count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    if (entity_count == 0) entity_count = 1;
+
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    std::string text_path = (directory / "level_load_bench.txt").string();
+    std::string cooked_path = (directory / "level_load_bench.lvlb").string();
+
+    write_text_level(text_path, entity_count);
+    {
+        level_data level;
+        if (!read_level_text(text_path, level) || !cook_level(level, cooked_path)) return 1;
+    }
+
+    std::printf("%zu entities\n", entity_count);
+
+    const storage_mode modes[] = { storage_mode::SPARSE_SET, storage_mode::ARCHETYPE };
+    for (storage_mode mode : modes) {
+        const char* storage = mode == storage_mode::SPARSE_SET ? "sparse" : "archetype";
+
+        {
+            Simulation simulation(single_thread(mode));
+            auto start = std::chrono::steady_clock::now();
+            create_level(simulation, entity_count);
+            std::printf("%-10s %-8s %10.2f ms\n", storage, "code", milliseconds_since(start));
+        }
+
+        {
+            Simulation simulation(single_thread(mode));
+            size_t loaded = 0;
+            auto start = std::chrono::steady_clock::now();
+            bool ok = load_level(simulation.em, text_path, loaded);
+            std::printf("%-10s %-8s %10.2f ms%s\n", storage, "text", milliseconds_since(start), ok ? "" : " (failed)");
+        }
+
+        {
+            Simulation simulation(single_thread(mode));
+            size_t loaded = 0;
+            auto start = std::chrono::steady_clock::now();
+            bool ok = load_level(simulation.em, cooked_path, loaded);
+            std::printf("%-10s %-8s %10.2f ms%s\n", storage, "cooked", milliseconds_since(start), ok ? "" : " (failed)");
+        }
+    }
+
+    std::filesystem::remove(text_path);
+    std::filesystem::remove(cooked_path);
+    return 0;
+}
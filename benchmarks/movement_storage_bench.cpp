@@ -0,0 +1,76 @@
+//compares Movement_System::update over the sparse set and the archetype storage modes.
+//build together with entity.cpp, archetype.cpp and movement.cpp from platforming_game/ and link SDL3
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "entity.h"
+#include "movement.h"
+
+namespace {
+    //roughly the mix of entities of a level: mostly enemies, some static geometry and a few players
+    void populate(entity_manager& em, size_t entity_count) {
+        for (size_t i = 0; i < entity_count; ++i) {
+            entity_handle id = em.new_entity();
+            auto* position = em.assign_component<components::position>(id);
+            position->pos = { static_cast<double>(i % 1000) * 10.0, static_cast<double>(i / 1000) * 10.0 };
+
+            auto* collision = em.assign_component<components::collision>(id);
+            collision->hitbox = { static_cast<float>(position->pos.x), static_cast<float>(position->pos.y), 30, 30 };
+            em.assign_component<components::render>(id);
+
+            if (i % 10 == 0) {
+                //static level geometry
+                collision->is_rigid = true;
+                continue;
+            }
+
+            auto* movement = em.assign_component<components::movement>(id);
+            movement->max_speed = { 100.0, 100.0 };
+            em.assign_component<components::gravity>(id);
+
+            if (i % 100 == 1) {
+                em.assign_component<components::input>(id);
+                em.assign_component<components::jump>(id);
+                em.assign_component<components::health>(id);
+            }
+            else {
+                em.assign_component<components::damage>(id)->damage_amount = 5;
+            }
+        }
+    }
+
+    double run(storage_mode mode, size_t entity_count, int iterations) {
+        entity_manager em(mode);
+        Input_Handler input;
+        Collision_System collision(em);
+        Movement_System movement(em, input, collision);
+
+        populate(em, entity_count);
+        movement.update(1.0 / 60.0); //warm up
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            movement.update(1.0 / 60.0);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        return std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+    }
+}
+
+int main() {
+    const size_t entity_counts[] = { 1000, 10000, 100000 };
+
+    std::printf("%10s %18s %18s %10s\n", "entities", "sparse set (us)", "archetype (us)", "speedup");
+
+    for (size_t entity_count : entity_counts) {
+        int iterations = static_cast<int>(2000000 / entity_count);
+
+        double sparse = run(storage_mode::SPARSE_SET, entity_count, iterations);
+        double archetype = run(storage_mode::ARCHETYPE, entity_count, iterations);
+
+        std::printf("%10zu %18.2f %18.2f %9.2fx\n", entity_count, sparse, archetype, sparse / archetype);
+    }
+
+    return 0;
+}
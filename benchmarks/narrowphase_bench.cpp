@@ -0,0 +1,99 @@
+//pairs per second through the batched overlap test, scalar against the SIMD versions. the pairs are the
+//candidates the grid broadphase finds on a crowded side-scrolling layout, so most of them don't overlap,
+//like the contacts Collision_System tests every step. gathering the hitboxes into the batch is timed too
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "broadphase.h"
+#include "narrowphase.h"
+
+namespace {
+    std::vector<broadphase_body> make_level(size_t body_count) {
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> height(0.0f, 400.0f);
+        std::uniform_real_distribution<float> size(16.0f, 48.0f);
+
+        std::vector<broadphase_body> bodies;
+        for (size_t i = 0; i < body_count; ++i) {
+            SDL_FRect box{ static_cast<float>(i) * 12.0f, height(rng), size(rng), size(rng) };
+            bodies.push_back(broadphase_body{ entity_handle{ static_cast<std::uint32_t>(i), 0 }, box });
+        }
+        return bodies;
+    }
+
+    struct result {
+        double gather_ns = 0.0; //per pair
+        double test_ns = 0.0; //per pair
+        size_t overlapping = 0;
+    };
+
+    result run(simd_isa isa, const std::vector<broadphase_body>& bodies, const std::vector<body_pair>& pairs,
+        std::vector<std::uint8_t>& directions, int repeats) {
+        pair_batch batch;
+        result r;
+        directions.assign(pairs.size(), CONTACT_NONE);
+
+        for (int repeat = 0; repeat < repeats; ++repeat) {
+            auto start = std::chrono::steady_clock::now();
+
+            batch.resize(pairs.size());
+            for (size_t i = 0; i < pairs.size(); ++i) {
+                batch.set(i, bodies[pairs[i].first.index].box, bodies[pairs[i].second.index].box);
+            }
+
+            auto gathered = std::chrono::steady_clock::now();
+            overlap_directions(batch, directions.data(), isa);
+            auto end = std::chrono::steady_clock::now();
+
+            r.gather_ns += std::chrono::duration<double, std::nano>(gathered - start).count();
+            r.test_ns += std::chrono::duration<double, std::nano>(end - gathered).count();
+        }
+
+        double tests = static_cast<double>(pairs.size()) * repeats;
+        r.gather_ns /= tests;
+        r.test_ns /= tests;
+        for (std::uint8_t direction : directions) {
+            if (direction != CONTACT_NONE) r.overlapping++;
+        }
+        return r;
+    }
+}
+
+int main() {
+    const size_t body_counts[] = { 1000, 10000, 50000 };
+    const int repeats = 200;
+    const simd_isa isas[] = { simd_isa::SCALAR, simd_isa::SSE, simd_isa::AVX2 };
+
+    std::printf("best supported: %s\n", simd_isa_name(best_simd_isa()));
+    std::printf("%8s %10s %10s %8s %14s %14s %12s %10s\n", "bodies", "pairs", "overlaps", "isa", "test (ns/pair)", "Mpairs/s", "gather (ns)", "mismatches");
+
+    for (size_t body_count : body_counts) {
+        auto bodies = make_level(body_count);
+        auto broadphase = make_broadphase(broadphase_settings());
+        broadphase->update(bodies);
+        const std::vector<body_pair>& pairs = broadphase->candidate_pairs();
+
+        std::vector<std::uint8_t> reference;
+        std::vector<std::uint8_t> directions;
+
+        for (simd_isa isa : isas) {
+            //an unsupported isa would silently run the best one instead
+            if (isa == simd_isa::AVX2 && best_simd_isa() != simd_isa::AVX2) continue;
+            if (isa != simd_isa::SCALAR && best_simd_isa() == simd_isa::SCALAR) continue;
+
+            result r = run(isa, bodies, pairs, directions, repeats);
+            if (isa == simd_isa::SCALAR) reference = directions;
+
+            size_t mismatches = 0;
+            for (size_t i = 0; i < directions.size(); ++i) {
+                if (directions[i] != reference[i]) mismatches++;
+            }
+
+            std::printf("%8zu %10zu %10zu %8s %14.3f %14.1f %12.3f %10zu\n", body_count, pairs.size(), r.overlapping,
+                simd_isa_name(isa), r.test_ns, 1000.0 / r.test_ns, r.gather_ns, mismatches);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,109 @@
+//headless scaling benchmark of the system scheduler: the movement, collision and health systems run
+//through System_Scheduler with thread pools of increasing size. the final state is hashed for every
+//thread count to check the simulation stays deterministic.
+//build together with the platforming_game/ sources except main.cpp and game.cpp, and link SDL3
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "entity.h"
+#include "health_system.h"
+#include "job_system.h"
+#include "movement.h"
+
+namespace {
+    void populate(entity_manager& em, size_t enemy_count) {
+        //one long floor and a row of falling enemies spread along it
+        entity_handle floor_id = em.new_entity();
+        em.assign_component<components::position>(floor_id)->pos = { -1000.0, 600.0 };
+        auto* floor_collision = em.assign_component<components::collision>(floor_id);
+        floor_collision->hitbox = { -1000.0f, 600.0f, static_cast<float>(enemy_count) * 40.0f + 2000.0f, 200.0f };
+        floor_collision->is_rigid = true;
+
+        for (size_t i = 0; i < enemy_count; ++i) {
+            entity_handle id = em.new_entity();
+            auto* position = em.assign_component<components::position>(id);
+            position->pos = { static_cast<double>(i) * 40.0, static_cast<double>(i % 50) * 10.0 };
+
+            auto* movement = em.assign_component<components::movement>(id);
+            movement->max_speed = { 100.0, 100.0 };
+            movement->speed.x = (i % 2 == 0) ? 0.5 : -0.5;
+
+            em.assign_component<components::gravity>(id);
+            em.assign_component<components::damage>(id)->damage_amount = 5;
+
+            auto* collision = em.assign_component<components::collision>(id);
+            collision->hitbox = { static_cast<float>(position->pos.x), static_cast<float>(position->pos.y), 30.0f, 30.0f };
+        }
+    }
+
+    unsigned long long hash_state(entity_manager& em) {
+        unsigned long long hash = 1469598103934665603ull;
+        for (auto [id, position] : em.view<components::position>()) {
+            unsigned long long bits[2];
+            std::memcpy(&bits[0], &position.pos.x, sizeof(double));
+            std::memcpy(&bits[1], &position.pos.y, sizeof(double));
+            hash = (hash ^ id.index ^ bits[0] ^ (bits[1] << 1)) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    double run(unsigned int threads, size_t enemy_count, int ticks, unsigned long long& state_hash) {
+        entity_manager em;
+        Input_Handler input;
+        Thread_Pool pool(threads);
+        System_Scheduler scheduler(pool, em);
+
+        broadphase_settings settings;
+        settings.sleep_frames = ticks + 1; //keep every body awake, this measures simulation cost
+
+        Collision_System collision(em, settings);
+        Movement_System movement(em, input, collision, &pool);
+        Health_System health(em, &pool);
+
+        scheduler.add_system("movement", Movement_System::access(), [&](double dt) { movement.update(dt); });
+        scheduler.add_system("collision", Collision_System::access(), [&](double) { collision.update(); });
+        scheduler.add_system("health", Health_System::access(), [&](double dt) { health.update(dt); });
+
+        populate(em, enemy_count);
+        collision.build_static_tier();
+
+        auto start = std::chrono::steady_clock::now();
+        for (int tick = 0; tick < ticks; ++tick) {
+            scheduler.run(1.0 / 60.0);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        state_hash = hash_state(em);
+        return ticks / std::chrono::duration<double>(end - start).count();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t enemy_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    int ticks = argc > 2 ? std::atoi(argv[2]) : 300;
+
+    std::printf("%zu enemies, %d ticks\n", enemy_count, ticks);
+    std::printf("%8s %14s %10s %20s\n", "threads", "ticks/s", "speedup", "state hash");
+
+    unsigned long long reference_hash = 0;
+    double reference_rate = 0.0;
+    bool deterministic = true;
+
+    const unsigned int thread_counts[] = { 1, 2, 4, 8 };
+    for (unsigned int threads : thread_counts) {
+        unsigned long long state_hash = 0;
+        double rate = run(threads, enemy_count, ticks, state_hash);
+
+        if (threads == 1) {
+            reference_hash = state_hash;
+            reference_rate = rate;
+        }
+        deterministic = deterministic && state_hash == reference_hash;
+
+        std::printf("%8u %14.1f %9.2fx %20llx\n", threads, rate, rate / reference_rate, state_hash);
+    }
+
+    std::printf("deterministic: %s\n", deterministic ? "yes" : "NO");
+    return deterministic ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+//collision cost of bodies standing on level geometry made of tiles, once with every tile as a
+//static entity in the Collision_System's static tier and once with the tiles in a Tilemap.
+//the cost per body should stay flat with the tilemap however long the level gets.
+//build from the root CMakeLists.txt, usage: tilemap_bench [bodies] [ticks]
+#include <cstdio>
+#include <cstdlib>
+#include "simulation.h"
+
+namespace {
+    const float tile_size = 32.0f;
+
+    simulation_settings bench_settings() {
+        simulation_settings settings;
+        settings.threads = 1;
+        settings.streaming.enabled = false;
+        settings.collision.sleep_frames = 1 << 30; //keep every body awake, resting bodies would cost nothing
+        return settings;
+    }
+
+    //ground two tiles thick, the bodies spread along it
+    void populate(Simulation& simulation, int columns, size_t bodies, bool use_tilemap) {
+        if (use_tilemap) {
+            simulation.tilemap = Tilemap(columns, 2, tile_size, 0.0f, 600.0f);
+            tile_type ground;
+            ground.solid = true;
+            simulation.tilemap.define_tile(1, ground);
+            for (int row = 0; row < 2; ++row) {
+                for (int column = 0; column < columns; ++column) {
+                    simulation.tilemap.set(column, row, 1);
+                }
+            }
+        }
+        else {
+            for (int row = 0; row < 2; ++row) {
+                for (int column = 0; column < columns; ++column) {
+                    simulation.create_platform({ column * tile_size, 600.0f + row * tile_size, tile_size, tile_size }, { 0x00,0x00,0xFF,0xFF });
+                }
+            }
+        }
+
+        float level_width = columns * tile_size;
+        for (size_t i = 0; i < bodies; ++i) {
+            simulation.create_enemy(level_width * (static_cast<double>(i) + 0.5) / static_cast<double>(bodies), 500.0);
+        }
+
+        simulation.finish_level();
+    }
+
+    //microseconds of collision update per body and tick
+    double run(int columns, size_t bodies, int ticks, bool use_tilemap) {
+        Simulation simulation(bench_settings());
+        populate(simulation, columns, bodies, use_tilemap);
+
+        //let the bodies land first
+        for (int tick = 0; tick < 120; ++tick) {
+            simulation.step(1.0 / SIMULATION_RATE);
+        }
+
+        size_t collision_index = 0;
+        for (size_t i = 0; i < simulation.scheduler.system_count(); ++i) {
+            if (simulation.scheduler.system_name(i) == "collision") collision_index = i;
+        }
+
+        double before = simulation.scheduler.system_total_time(collision_index);
+        for (int tick = 0; tick < ticks; ++tick) {
+            simulation.step(1.0 / SIMULATION_RATE);
+        }
+        double seconds = simulation.scheduler.system_total_time(collision_index) - before;
+
+        return seconds * 1e6 / (static_cast<double>(ticks) * bodies);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t bodies = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+    int ticks = argc > 2 ? std::atoi(argv[2]) : 240;
+    if (bodies == 0) bodies = 1;
+
+    std::printf("%zu bodies, %d ticks, us of collision per body and tick\n", bodies, ticks);
+    std::printf("%12s %14s %14s\n", "tiles", "entity tiles", "tilemap");
+
+    for (int columns : { 1000, 10000, 100000 }) {
+        double entities = run(columns, bodies, ticks, false);
+        double tiles = run(columns, bodies, ticks, true);
+        std::printf("%12d %14.3f %14.3f\n", columns * 2, entities, tiles);
+    }
+    return 0;
+}
@@ -0,0 +1,202 @@
+#include <algorithm>
+#include "entity.h"
+
+archetype_storage::archetype_storage() {
+    //entities without components live in the empty archetype
+    find_or_create(std::bitset<MAX_COMPONENTS>());
+}
+
+archetype_storage::~archetype_storage() {
+    for (auto& arch : archetypes) {
+        for (auto& chunk : arch->chunks) {
+            delete[] chunk.data;
+        }
+    }
+}
+
+void archetype_storage::register_component(int component_id, size_t size, size_t alignment) {
+    component_sizes[component_id] = size;
+    component_alignments[component_id] = alignment;
+}
+
+archetype* archetype_storage::find_or_create(const std::bitset<MAX_COMPONENTS>& signature) {
+    auto found = archetype_lookup.find(signature);
+    if (found != archetype_lookup.end()) {
+        return found->second;
+    }
+
+    auto arch = std::make_unique<archetype>();
+    arch->signature = signature;
+    arch->column_offset.fill(archetype::no_column);
+    arch->column_stride.fill(0);
+
+    size_t bytes_per_entity = sizeof(entity_handle);
+    size_t padding = 0;
+    for (size_t i = 0; i < MAX_COMPONENTS; ++i) {
+        if (signature.test(i)) {
+            bytes_per_entity += component_sizes[i];
+            padding += component_alignments[i];
+        }
+    }
+
+    //fit as many entities as possible once every column has been aligned. an entity that doesn't fit
+    //gets one chunk to itself, made as large as the layout below needs
+    arch->capacity = padding < ARCHETYPE_CHUNK_BYTES ? (ARCHETYPE_CHUNK_BYTES - padding) / bytes_per_entity : 0;
+    if (arch->capacity == 0) arch->capacity = 1;
+
+    size_t offset = 0;
+    arch->ids_offset = offset;
+    offset += sizeof(entity_handle) * arch->capacity;
+
+    for (size_t i = 0; i < MAX_COMPONENTS; ++i) {
+        if (!signature.test(i)) continue;
+
+        size_t alignment = component_alignments[i];
+        offset = (offset + alignment - 1) / alignment * alignment;
+
+        arch->column_offset[i] = offset;
+        arch->column_stride[i] = component_sizes[i];
+        offset += component_sizes[i] * arch->capacity;
+    }
+    arch->chunk_bytes = std::max<size_t>(ARCHETYPE_CHUNK_BYTES, offset);
+
+    archetype* result = arch.get();
+    archetypes.push_back(std::move(arch));
+    archetype_lookup.emplace(signature, result);
+    return result;
+}
+
+entity_location& archetype_storage::location_of(entity_handle id) {
+    if (id.index >= locations.size()) {
+        locations.resize(id.index + 1);
+    }
+    return locations[id.index];
+}
+
+size_t archetype_storage::push_row(archetype* arch, entity_handle id) {
+    size_t row = arch->size;
+
+    if (row == arch->chunks.size() * arch->capacity) {
+        //chunk allocations are large enough to hold any column alignment (new[] returns max aligned memory)
+        arch->chunks.push_back(archetype_chunk{ new char[arch->chunk_bytes], 0 });
+    }
+
+    archetype_chunk& chunk = arch->chunks[row / arch->capacity];
+    arch->ids(chunk)[chunk.count] = id;
+    chunk.count++;
+    arch->size++;
+
+    return row;
+}
+
+void archetype_storage::pop_row(archetype* arch, size_t row) {
+    size_t last = arch->size - 1;
+    archetype_chunk& last_chunk = arch->chunks[last / arch->capacity];
+
+    if (row != last) {
+        //move the last entity of the archetype into the freed row
+        archetype_chunk& chunk = arch->chunks[row / arch->capacity];
+        entity_handle moved_id = arch->ids(last_chunk)[last % arch->capacity];
+
+        for (size_t i = 0; i < MAX_COMPONENTS; ++i) {
+            if (arch->signature.test(i)) {
+                std::memcpy(arch->element(row, i), arch->element(last, i), arch->column_stride[i]);
+            }
+        }
+
+        arch->ids(chunk)[row % arch->capacity] = moved_id;
+        locations[moved_id.index].row = row;
+    }
+
+    last_chunk.count--;
+    arch->size--;
+}
+
+void archetype_storage::move_entity(entity_handle id, archetype* destination) {
+    entity_location& location = location_of(id);
+    archetype* source = location.arch;
+
+    size_t new_row = push_row(destination, id);
+
+    if (source) {
+        //copy the components both archetypes have in common
+        std::bitset<MAX_COMPONENTS> shared = source->signature & destination->signature;
+        for (size_t i = 0; i < MAX_COMPONENTS; ++i) {
+            if (shared.test(i)) {
+                std::memcpy(destination->element(new_row, i), source->element(location.row, i), component_sizes[i]);
+            }
+        }
+
+        pop_row(source, location.row);
+    }
+
+    location.arch = destination;
+    location.row = new_row;
+}
+
+void* archetype_storage::add(entity_handle id, int component_id) {
+    entity_location& location = location_of(id);
+
+    //entities without components aren't stored anywhere, they start from the empty archetype
+    archetype* source = location.arch ? location.arch : archetypes.front().get();
+    if (source->signature.test(component_id)) {
+        return source->element(location.row, component_id);
+    }
+
+    archetype* destination = source->add_edge[component_id];
+    if (!destination) {
+        std::bitset<MAX_COMPONENTS> signature = source->signature;
+        signature.set(component_id);
+        destination = find_or_create(signature);
+        source->add_edge[component_id] = destination;
+        destination->remove_edge[component_id] = source;
+    }
+
+    move_entity(id, destination);
+    return destination->element(location.row, component_id);
+}
+
+void archetype_storage::place(entity_handle id, const std::bitset<MAX_COMPONENTS>& signature) {
+    archetype* destination = find_or_create(signature);
+    size_t row = push_row(destination, id);
+    location_of(id) = entity_location{ destination, row };
+}
+
+void archetype_storage::remove(entity_handle id, int component_id) {
+    if (id.index >= locations.size() || !locations[id.index].arch) return;
+
+    archetype* source = locations[id.index].arch;
+    if (!source->signature.test(component_id)) return;
+
+    archetype* destination = source->remove_edge[component_id];
+    if (!destination) {
+        std::bitset<MAX_COMPONENTS> signature = source->signature;
+        signature.reset(component_id);
+        destination = find_or_create(signature);
+        source->remove_edge[component_id] = destination;
+        destination->add_edge[component_id] = source;
+    }
+
+    if (destination->signature.none()) {
+        remove_all(id);
+        return;
+    }
+
+    move_entity(id, destination);
+}
+
+void archetype_storage::remove_all(entity_handle id) {
+    if (id.index >= locations.size() || !locations[id.index].arch) return;
+
+    pop_row(locations[id.index].arch, locations[id.index].row);
+    locations[id.index] = entity_location{};
+}
+
+void* archetype_storage::get(entity_handle id, int component_id) {
+    if (id.index >= locations.size() || !locations[id.index].arch) return nullptr;
+
+    archetype* arch = locations[id.index].arch;
+    if (!arch->signature.test(component_id)) return nullptr;
+
+    return arch->element(locations[id.index].row, component_id);
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include <array>
+#include <bitset>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "entity_handle.h"
+
+//included from entity.h, which defines MAX_COMPONENTS
+
+#define ARCHETYPE_CHUNK_BYTES (16 * 1024) //size of an archetype chunk, entity handles included
+
+//a fixed-size block of memory holding up to archetype::capacity entities of one archetype.
+//the block is split into one contiguous column per component plus a column of entity handles
+struct archetype_chunk {
+    char* data = nullptr;
+    size_t count = 0;
+};
+
+//all entities sharing the same component signature
+struct archetype {
+    static constexpr size_t no_column = static_cast<size_t>(-1);
+
+    std::bitset<MAX_COMPONENTS> signature;
+    size_t capacity = 0; //entities per chunk
+    size_t chunk_bytes = ARCHETYPE_CHUNK_BYTES; //larger only when a single entity doesn't fit in ARCHETYPE_CHUNK_BYTES
+    size_t size = 0; //entities stored in all chunks
+    size_t ids_offset = 0; //byte offset of the entity handle column inside a chunk
+    std::array<size_t, MAX_COMPONENTS> column_offset; //byte offset of each component column, no_column if absent
+    std::array<size_t, MAX_COMPONENTS> column_stride;
+    std::vector<archetype_chunk> chunks;
+
+    //cached transitions when adding or removing a single component
+    std::array<archetype*, MAX_COMPONENTS> add_edge{};
+    std::array<archetype*, MAX_COMPONENTS> remove_edge{};
+
+    inline entity_handle* ids(archetype_chunk& chunk) {
+        return reinterpret_cast<entity_handle*>(chunk.data + ids_offset);
+    }
+
+    inline void* column(archetype_chunk& chunk, int component_id) {
+        if (column_offset[component_id] == no_column) return nullptr;
+        return chunk.data + column_offset[component_id];
+    }
+
+    inline void* element(size_t row, int component_id) {
+        archetype_chunk& chunk = chunks[row / capacity];
+        return chunk.data + column_offset[component_id] + (row % capacity) * column_stride[component_id];
+    }
+};
+
+//where an entity lives inside the archetype storage
+struct entity_location {
+    archetype* arch = nullptr;
+    size_t row = 0;
+};
+
+//a chunk handed to systems iterating the archetype storage
+struct chunk_view {
+    archetype* arch;
+    archetype_chunk* chunk;
+
+    inline size_t size() const {
+        return chunk->count;
+    }
+
+    inline const entity_handle* ids() const {
+        return arch->ids(*chunk);
+    }
+
+    inline bool has(int component_id) const {
+        return arch->signature.test(component_id);
+    }
+
+    //column of a component type, nullptr if the archetype doesn't have it
+    template<class T>
+    T* column(int component_id) const {
+        return static_cast<T*>(arch->column(*chunk, component_id));
+    }
+};
+
+//archetype based component storage: entities with the same component mask are packed together
+//in 16KB chunks, each component stored as its own contiguous column. adding or removing a
+//component moves the entity (and its components) to the archetype matching its new mask
+class archetype_storage {
+public:
+    archetype_storage();
+    ~archetype_storage();
+
+    archetype_storage(const archetype_storage&) = delete;
+    archetype_storage& operator=(const archetype_storage&) = delete;
+
+    //sizes are needed to lay out the columns of an archetype before any component is stored
+    void register_component(int component_id, size_t size, size_t alignment);
+
+    //moves the entity into the archetype that also contains component_id and returns the
+    //uninitialized storage for the new component, or the existing one if it already had it
+    void* add(entity_handle id, int component_id);
+
+    //stores an entity without components straight into the archetype of `signature`, its components uninitialized
+    void place(entity_handle id, const std::bitset<MAX_COMPONENTS>& signature);
+    void remove(entity_handle id, int component_id);
+    void remove_all(entity_handle id);
+    void* get(entity_handle id, int component_id);
+
+    //calls fn(chunk_view&) for every non empty chunk whose archetype contains all required components and none of the excluded ones
+    template<class Fn>
+    void for_each_chunk(const std::bitset<MAX_COMPONENTS>& required, const std::bitset<MAX_COMPONENTS>& excluded, Fn&& fn) {
+        for (auto& arch : archetypes) {
+            if ((arch->signature & required) != required || (arch->signature & excluded).any()) continue;
+
+            for (auto& chunk : arch->chunks) {
+                if (chunk.count == 0) continue;
+                chunk_view view{ arch.get(), &chunk };
+                fn(view);
+            }
+        }
+    }
+
+    size_t archetype_count() const {
+        return archetypes.size();
+    }
+
+private:
+    archetype* find_or_create(const std::bitset<MAX_COMPONENTS>& signature);
+    size_t push_row(archetype* arch, entity_handle id);
+    void pop_row(archetype* arch, size_t row);
+    void move_entity(entity_handle id, archetype* destination);
+    entity_location& location_of(entity_handle id);
+
+    std::vector<std::unique_ptr<archetype>> archetypes;
+    std::unordered_map<std::bitset<MAX_COMPONENTS>, archetype*> archetype_lookup;
+    std::vector<entity_location> locations; //indexed by entity slot
+
+    std::array<size_t, MAX_COMPONENTS> component_sizes{};
+    std::array<size_t, MAX_COMPONENTS> component_alignments{};
+};
@@ -0,0 +1,157 @@
+#include "asset_manager.h"
+#include <SDL3/SDL_image.h>
+#include "logger.h"
+
+Asset_Manager::Asset_Manager(Texture_Atlas& atlas, unsigned int loader_threads) : atlas(atlas) {
+    if (loader_threads == 0) loader_threads = 1;
+
+    for (unsigned int i = 0; i < loader_threads; ++i) {
+        loaders.emplace_back(&Asset_Manager::loader_loop, this);
+    }
+}
+
+Asset_Manager::~Asset_Manager() {
+    stop();
+}
+
+void Asset_Manager::stop() {
+    {
+        std::lock_guard<std::mutex> guard(queue_lock);
+        stopping = true;
+    }
+    queue_changed.notify_all();
+
+    for (auto& loader : loaders) {
+        loader.join();
+    }
+    loaders.clear();
+}
+
+double Asset_Manager::elapsed_ms(Uint64 since) const {
+    return static_cast<double>(SDL_GetPerformanceCounter() - since) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+asset_handle Asset_Manager::load_image(const std::string& name, const std::string& path) {
+    auto request = std::make_unique<asset>();
+    request->name = name;
+    request->path = path;
+    request->requested = SDL_GetPerformanceCounter();
+
+    asset* queued = request.get();
+    asset_handle handle = static_cast<asset_handle>(assets.size());
+    assets.push_back(std::move(request));
+
+    {
+        std::lock_guard<std::mutex> guard(queue_lock);
+        queue.push_back(queued);
+    }
+    queue_changed.notify_one();
+
+    return handle;
+}
+
+void Asset_Manager::loader_loop() {
+    while (true) {
+        asset* request;
+        {
+            std::unique_lock<std::mutex> guard(queue_lock);
+            queue_changed.wait(guard, [this]() { return stopping || !queue.empty(); });
+            if (stopping) return;
+
+            request = queue.front();
+            queue.pop_front();
+            decoding++;
+        }
+
+        decode(*request);
+
+        {
+            std::lock_guard<std::mutex> guard(queue_lock);
+            decoding--;
+        }
+        queue_changed.notify_all();
+    }
+}
+
+void Asset_Manager::decode(asset& request) {
+    size_t size = 0;
+    void* data = SDL_LoadFile(request.path.c_str(), &size);
+    if (!data) {
+        LOG_ERROR("Could not read asset {}: {}", request.path, SDL_GetError());
+        request.state = asset_state::FAILED;
+        return;
+    }
+
+    SDL_Surface* surface = IMG_Load_IO(SDL_IOFromConstMem(data, size), true);
+    SDL_free(data);
+
+    if (surface && surface->format != SDL_PIXELFORMAT_RGBA32) {
+        SDL_Surface* converted = SDL_ConvertSurface(surface, SDL_PIXELFORMAT_RGBA32);
+        SDL_DestroySurface(surface);
+        surface = converted;
+    }
+
+    if (!surface) {
+        LOG_ERROR("Could not decode asset {}: {}", request.path, SDL_GetError());
+        request.state = asset_state::FAILED;
+        return;
+    }
+
+    request.region = atlas.insert(request.name, surface, request.ticket);
+    SDL_DestroySurface(surface);
+
+    request.timing.decoded = elapsed_ms(request.requested);
+    request.state = request.region.page >= 0 ? asset_state::UPLOADING : asset_state::FAILED;
+}
+
+void Asset_Manager::update(SDL_Renderer* renderer, double budget_seconds) {
+    atlas.upload(renderer, budget_seconds);
+    unsigned long long uploaded = atlas.uploaded_count();
+
+    for (size_t i = first_unfinished; i < assets.size(); ++i) {
+        asset& request = *assets[i];
+        if (request.state == asset_state::UPLOADING && request.ticket < uploaded) {
+            request.timing.ready = elapsed_ms(request.requested);
+            request.state = asset_state::READY;
+
+            LOG_INFO("Asset {} decoded in {} ms, ready in {} ms", request.name, request.timing.decoded, request.timing.ready);
+        }
+    }
+
+    while (first_unfinished < assets.size() &&
+        (assets[first_unfinished]->state == asset_state::READY || assets[first_unfinished]->state == asset_state::FAILED)) {
+        first_unfinished++;
+    }
+}
+
+void Asset_Manager::finish(SDL_Renderer* renderer) {
+    {
+        std::unique_lock<std::mutex> guard(queue_lock);
+        queue_changed.wait(guard, [this]() { return queue.empty() && decoding == 0; });
+    }
+
+    while (!idle()) {
+        update(renderer, 1.0);
+    }
+}
+
+asset_state Asset_Manager::state(asset_handle handle) const {
+    return assets[handle]->state;
+}
+
+types::atlas_region Asset_Manager::region(asset_handle handle) const {
+    if (assets[handle]->state != asset_state::READY) return types::atlas_region();
+    return assets[handle]->region;
+}
+
+const asset_timing& Asset_Manager::timing(asset_handle handle) const {
+    return assets[handle]->timing;
+}
+
+const std::string& Asset_Manager::name(asset_handle handle) const {
+    return assets[handle]->name;
+}
+
+bool Asset_Manager::idle() const {
+    return first_unfinished == assets.size();
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "texture_atlas.h"
+
+#define ASSET_LOADER_THREADS 2
+
+using asset_handle = unsigned int;
+
+enum class asset_state {
+    LOADING, //queued, being read or decoded
+    UPLOADING, //packed into the atlas, waiting for its texture upload
+    READY,
+    FAILED
+};
+
+//load times of an asset, in milliseconds since it was requested
+struct asset_timing {
+    double decoded = 0.0; //file read, decoded and packed
+    double ready = 0.0; //uploaded, can be drawn
+};
+
+//loads images in the background: file reads, SDL_image decoding and atlas packing run on loader
+//threads of their own (the simulation's Thread_Pool runs whatever job it finds while waiting, a
+//decode landing there would stall a frame). only texture uploads run on the renderer thread, in
+//update, within a time budget per frame
+class Asset_Manager {
+public:
+    Asset_Manager(Texture_Atlas& atlas, unsigned int loader_threads = ASSET_LOADER_THREADS);
+    ~Asset_Manager();
+
+    Asset_Manager(const Asset_Manager&) = delete;
+    Asset_Manager& operator=(const Asset_Manager&) = delete;
+
+    //returns right away, the image is drawable once its state is READY
+    asset_handle load_image(const std::string& name, const std::string& path);
+
+    //uploads decoded images for at most `budget_seconds` and updates the asset states.
+    //renderer thread only, meant to be called once per frame
+    void update(SDL_Renderer* renderer, double budget_seconds);
+
+    //blocks until every requested asset is READY or FAILED
+    void finish(SDL_Renderer* renderer);
+
+    asset_state state(asset_handle handle) const;
+
+    //region of a READY image, page -1 otherwise
+    types::atlas_region region(asset_handle handle) const;
+
+    const asset_timing& timing(asset_handle handle) const;
+    const std::string& name(asset_handle handle) const;
+
+    //no request is loading or uploading
+    bool idle() const;
+
+    //joins the loader threads, requests they didn't pick up stay LOADING. has to run before SDL shuts
+    //down, the destructor calls it too
+    void stop();
+
+private:
+    struct asset {
+        std::string name;
+        std::string path;
+        Uint64 requested; //performance counter
+        std::atomic<asset_state> state{ asset_state::LOADING };
+        types::atlas_region region;
+        unsigned long long ticket = 0; //atlas upload ticket
+        asset_timing timing;
+    };
+
+    void loader_loop();
+    void decode(asset& request);
+    double elapsed_ms(Uint64 since) const;
+
+    Texture_Atlas& atlas;
+    std::deque<std::unique_ptr<asset>> assets; //a handle is an index, entries never move
+    size_t first_unfinished = 0; //assets before it are READY or FAILED
+
+    mutable std::mutex queue_lock;
+    std::condition_variable queue_changed;
+    std::deque<asset*> queue;
+    size_t decoding = 0; //requests picked up by a loader and not decoded yet
+    bool stopping = false;
+    std::vector<std::thread> loaders;
+};
@@ -0,0 +1,280 @@
+#include "broadphase.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace {
+    inline body_pair make_pair_of(entity_handle a, entity_handle b) {
+        return a < b ? body_pair(a, b) : body_pair(b, a);
+    }
+
+    inline bool overlap_y(const SDL_FRect& a, const SDL_FRect& b) {
+        return a.y <= b.y + b.h && b.y <= a.y + a.h;
+    }
+
+    inline bool overlap(const SDL_FRect& a, const SDL_FRect& b) {
+        return a.x <= b.x + b.w && b.x <= a.x + a.w && overlap_y(a, b);
+    }
+
+    //packed coordinates of a grid cell and the bucket it is hashed into
+    inline long long cell_key(long long x, long long y) {
+        return static_cast<long long>((static_cast<unsigned long long>(x) << 32) ^ (static_cast<unsigned long long>(y) & 0xFFFFFFFF));
+    }
+
+    inline size_t cell_bucket(long long x, long long y, size_t bucket_count) {
+        return static_cast<size_t>((static_cast<unsigned long long>(x) * 73856093) ^ (static_cast<unsigned long long>(y) * 19349663)) & (bucket_count - 1);
+    }
+}
+
+void Broadphase::update(const std::vector<broadphase_body>& bodies) {
+    std::swap(previous_pairs, pairs);
+    pairs.clear();
+
+    find_pairs(bodies);
+    bodies_seen = bodies.size();
+
+    //a pair can be found more than once (bodies sharing several grid cells)
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+    began.clear();
+    ended.clear();
+    std::set_difference(pairs.begin(), pairs.end(), previous_pairs.begin(), previous_pairs.end(), std::back_inserter(began));
+    std::set_difference(previous_pairs.begin(), previous_pairs.end(), pairs.begin(), pairs.end(), std::back_inserter(ended));
+}
+
+void Broadphase::query(const SDL_FRect& box, std::vector<entity_handle>& out) const {
+    out.clear();
+    find_bodies(box, out);
+
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+std::unique_ptr<Broadphase> make_broadphase(const broadphase_settings& settings) {
+    switch (settings.type) {
+    case broadphase_type::SWEEP_AND_PRUNE:
+        return std::make_unique<Sweep_And_Prune_Broadphase>();
+    case broadphase_type::BRUTE_FORCE:
+        return std::make_unique<Brute_Force_Broadphase>();
+    case broadphase_type::SPATIAL_HASH:
+    default:
+        return std::make_unique<Spatial_Hash_Broadphase>(settings.cell_size, settings.max_cells_per_body);
+    }
+}
+
+Spatial_Hash_Broadphase::Spatial_Hash_Broadphase(float cell_size, int max_cells_per_body)
+    : cell_size(cell_size), max_cells_per_body(max_cells_per_body) {}
+
+void Spatial_Hash_Broadphase::find_pairs(const std::vector<broadphase_body>& bodies) {
+    oversized.clear();
+    oversized_ids.clear();
+
+    for (size_t bucket : used_buckets) {
+        buckets[bucket].clear();
+    }
+    used_buckets.clear();
+
+    //keep roughly two buckets per body so unrelated cells rarely share one
+    size_t bucket_count = 64;
+    while (bucket_count < bodies.size() * 2) {
+        bucket_count *= 2;
+    }
+    if (buckets.size() != bucket_count) {
+        buckets.clear();
+        buckets.resize(bucket_count);
+    }
+
+    const float inverse_cell = 1.0f / cell_size;
+
+    for (size_t i = 0; i < bodies.size(); ++i) {
+        const SDL_FRect& hitbox = bodies[i].box;
+        entity_handle id = bodies[i].id;
+
+        long long min_x = static_cast<long long>(std::floor(hitbox.x * inverse_cell));
+        long long min_y = static_cast<long long>(std::floor(hitbox.y * inverse_cell));
+        long long max_x = static_cast<long long>(std::floor((hitbox.x + hitbox.w) * inverse_cell));
+        long long max_y = static_cast<long long>(std::floor((hitbox.y + hitbox.h) * inverse_cell));
+
+        if ((max_x - min_x + 1) * (max_y - min_y + 1) > max_cells_per_body) {
+            oversized.push_back(i);
+            oversized_ids.push_back(id);
+            continue;
+        }
+
+        for (long long y = min_y; y <= max_y; ++y) {
+            for (long long x = min_x; x <= max_x; ++x) {
+                long long cell = cell_key(x, y);
+                size_t bucket = cell_bucket(x, y, bucket_count);
+
+                //pair against every body already inserted in the same cell
+                for (auto& entry : buckets[bucket]) {
+                    if (entry.cell == cell) {
+                        pairs.push_back(make_pair_of(entry.id, id));
+                    }
+                }
+
+                if (buckets[bucket].empty()) {
+                    used_buckets.push_back(bucket);
+                }
+                buckets[bucket].push_back(cell_entry{ cell, id });
+            }
+        }
+    }
+
+    //oversized bodies (like the death plane) are tested against everything else, including each other
+    for (size_t i = 0; i < oversized.size(); ++i) {
+        size_t body = oversized[i];
+
+        for (size_t other = 0; other < bodies.size(); ++other) {
+            if (other == body) continue;
+            pairs.push_back(make_pair_of(bodies[body].id, bodies[other].id));
+        }
+    }
+}
+
+void Spatial_Hash_Broadphase::find_bodies(const SDL_FRect& box, std::vector<entity_handle>& out) const {
+    out.insert(out.end(), oversized_ids.begin(), oversized_ids.end());
+    if (buckets.empty()) return;
+
+    const float inverse_cell = 1.0f / cell_size;
+    long long min_x = static_cast<long long>(std::floor(box.x * inverse_cell));
+    long long min_y = static_cast<long long>(std::floor(box.y * inverse_cell));
+    long long max_x = static_cast<long long>(std::floor((box.x + box.w) * inverse_cell));
+    long long max_y = static_cast<long long>(std::floor((box.y + box.h) * inverse_cell));
+
+    for (long long y = min_y; y <= max_y; ++y) {
+        for (long long x = min_x; x <= max_x; ++x) {
+            long long cell = cell_key(x, y);
+            for (auto& entry : buckets[cell_bucket(x, y, buckets.size())]) {
+                if (entry.cell == cell) out.push_back(entry.id);
+            }
+        }
+    }
+}
+
+void Sweep_And_Prune_Broadphase::find_pairs(const std::vector<broadphase_body>& bodies) {
+    ++update_count;
+    max_width = 0.0f;
+
+    //refresh the proxies, bodies seen for the first time add their two endpoints at the end
+    for (auto& body : bodies) {
+        std::uint32_t slot = body.id.index;
+        if (slot >= proxy_of.size()) {
+            proxy_of.resize(slot + 1, 0);
+        }
+
+        if (proxy_of[slot] == 0) {
+            unsigned int index;
+            if (!free_proxies.empty()) {
+                index = free_proxies.back();
+                free_proxies.pop_back();
+            }
+            else {
+                index = static_cast<unsigned int>(proxies.size());
+                proxies.push_back(proxy{});
+            }
+
+            proxies[index].id = body.id;
+            proxy_of[slot] = index + 1;
+
+            endpoints.push_back(endpoint{ body.box.x, index, false });
+            endpoints.push_back(endpoint{ body.box.x + body.box.w, index, true });
+        }
+
+        //an entity created in the slot of a deleted one takes over its proxy
+        proxy& p = proxies[proxy_of[slot] - 1];
+        p.id = body.id;
+        p.box = body.box;
+        p.last_seen = update_count;
+        max_width = std::max(max_width, body.box.w);
+    }
+
+    //drop the endpoints of bodies that are gone and refresh the rest
+    size_t kept = 0;
+    for (size_t i = 0; i < endpoints.size(); ++i) {
+        endpoint e = endpoints[i];
+        proxy& p = proxies[e.proxy];
+
+        if (p.last_seen != update_count) {
+            if (e.is_max) {
+                //only release the proxy once, on its max endpoint
+                if (p.id.index < proxy_of.size() && proxy_of[p.id.index] == e.proxy + 1) {
+                    proxy_of[p.id.index] = 0;
+                }
+                free_proxies.push_back(e.proxy);
+            }
+            continue;
+        }
+
+        e.value = e.is_max ? p.box.x + p.box.w : p.box.x;
+        endpoints[kept++] = e;
+    }
+    endpoints.resize(kept);
+
+    //insertion sort, almost no work when the order barely changes between frames.
+    //on equal values min endpoints go first so touching boxes still become candidates
+    for (size_t i = 1; i < endpoints.size(); ++i) {
+        endpoint e = endpoints[i];
+        size_t j = i;
+
+        while (j > 0 && (endpoints[j - 1].value > e.value ||
+            (endpoints[j - 1].value == e.value && endpoints[j - 1].is_max && !e.is_max))) {
+            endpoints[j] = endpoints[j - 1];
+            --j;
+        }
+
+        endpoints[j] = e;
+    }
+
+    //sweep: every interval opening is tested against the ones still open
+    active.clear();
+    for (auto& e : endpoints) {
+        proxy& p = proxies[e.proxy];
+
+        if (!e.is_max) {
+            for (unsigned int other : active) {
+                if (overlap_y(p.box, proxies[other].box)) {
+                    pairs.push_back(make_pair_of(p.id, proxies[other].id));
+                }
+            }
+
+            p.active_slot = active.size();
+            active.push_back(e.proxy);
+        }
+        else {
+            unsigned int last = active.back();
+            active[p.active_slot] = last;
+            proxies[last].active_slot = p.active_slot;
+            active.pop_back();
+        }
+    }
+}
+
+void Sweep_And_Prune_Broadphase::find_bodies(const SDL_FRect& box, std::vector<entity_handle>& out) const {
+    //the endpoints are sorted since the last update, a body overlapping the box opens no farther left than max_width
+    auto first = std::lower_bound(endpoints.begin(), endpoints.end(), box.x - max_width,
+        [](const endpoint& e, float value) { return e.value < value; });
+
+    for (auto it = first; it != endpoints.end() && it->value <= box.x + box.w; ++it) {
+        if (it->is_max) continue;
+
+        const proxy& p = proxies[it->proxy];
+        if (overlap(p.box, box)) out.push_back(p.id);
+    }
+}
+
+void Brute_Force_Broadphase::find_pairs(const std::vector<broadphase_body>& bodies) {
+    last_bodies = bodies;
+    for (size_t i = 0; i < bodies.size(); ++i) {
+        for (size_t j = i + 1; j < bodies.size(); ++j) {
+            pairs.push_back(make_pair_of(bodies[i].id, bodies[j].id));
+        }
+    }
+}
+
+void Brute_Force_Broadphase::find_bodies(const SDL_FRect& box, std::vector<entity_handle>& out) const {
+    for (auto& body : last_bodies) {
+        if (overlap(body.box, box)) out.push_back(body.id);
+    }
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "entity_handle.h"
+#include "narrowphase.h"
+
+using body_pair = std::pair<entity_handle, entity_handle>; //always stored as (lower handle, higher handle)
+
+//hitbox of an entity handed to the broadphase
+struct broadphase_body {
+    entity_handle id;
+    SDL_FRect box;
+};
+
+enum class broadphase_type {
+    SPATIAL_HASH,
+    SWEEP_AND_PRUNE,
+    BRUTE_FORCE //every pair is a candidate, what Game::update used to do. kept for benchmarking
+};
+
+//tunables of the broadphase stage of the Collision_System
+struct broadphase_settings {
+    broadphase_type type = broadphase_type::SPATIAL_HASH;
+    float cell_size = 128.0f; //side of a square grid cell, in pixels
+    int max_cells_per_body = 64; //bodies covering more cells than this skip the grid and are paired with every body
+
+    //dynamic bodies without input whose speed stays below the threshold for sleep_frames simulation steps are put to sleep
+    double sleep_speed_threshold = 0.05;
+    int sleep_frames = 120; //one second at the fixed simulation rate
+
+    //sweep dynamic bodies against rigid static geometry and tiles so fast ones can't tunnel through thin
+    //walls. off, only the overlaps left at the end of each step are resolved
+    bool continuous = true;
+
+    //version of the batched overlap test the contacts go through before being resolved
+    simd_isa narrowphase = best_simd_isa();
+};
+
+//finds the pairs of bodies that may be colliding. implementations only have to fill `pairs`,
+//the base class removes duplicates and reports which pairs started or stopped overlapping
+class Broadphase {
+public:
+    virtual ~Broadphase() {}
+
+    void update(const std::vector<broadphase_body>& bodies);
+
+    //candidate pairs of the last update, sorted and without duplicates
+    const std::vector<body_pair>& candidate_pairs() const {
+        return pairs;
+    }
+
+    //candidate pairs that appeared or disappeared in the last update
+    const std::vector<body_pair>& overlaps_began() const {
+        return began;
+    }
+
+    const std::vector<body_pair>& overlaps_ended() const {
+        return ended;
+    }
+
+    //bodies of the last update whose box may overlap `box`, sorted and without duplicates. it can
+    //return a few that don't overlap, callers test the ones they keep
+    void query(const SDL_FRect& box, std::vector<entity_handle>& out) const;
+
+    //bodies handed to the last update
+    size_t body_count() const {
+        return bodies_seen;
+    }
+
+protected:
+    virtual void find_pairs(const std::vector<broadphase_body>& bodies) = 0;
+    virtual void find_bodies(const SDL_FRect& box, std::vector<entity_handle>& out) const = 0;
+
+    std::vector<body_pair> pairs;
+
+private:
+    std::vector<body_pair> previous_pairs;
+    std::vector<body_pair> began;
+    std::vector<body_pair> ended;
+    size_t bodies_seen = 0;
+};
+
+std::unique_ptr<Broadphase> make_broadphase(const broadphase_settings& settings);
+
+//uniform grid hashed into buckets, rebuilt every update
+class Spatial_Hash_Broadphase : public Broadphase {
+public:
+    Spatial_Hash_Broadphase(float cell_size, int max_cells_per_body);
+
+protected:
+    void find_pairs(const std::vector<broadphase_body>& bodies) override;
+    void find_bodies(const SDL_FRect& box, std::vector<entity_handle>& out) const override; //looks at the cells `box` covers
+
+private:
+    struct cell_entry {
+        long long cell; //packed cell coordinates, buckets can hold entries of several cells
+        entity_handle id;
+    };
+
+    float cell_size;
+    int max_cells_per_body;
+
+    std::vector<std::vector<cell_entry>> buckets; //cells are hashed into a power of two bucket count
+    std::vector<size_t> used_buckets; //buckets filled this update, the only ones cleared on the next one
+    std::vector<size_t> oversized; //indices of bodies too large for the grid
+    std::vector<entity_handle> oversized_ids; //the same bodies, kept for queries
+};
+
+//sweep and prune on the x axis. the endpoint array is kept sorted between updates and re-sorted
+//with insertion sort, which is close to linear when bodies move coherently from frame to frame
+class Sweep_And_Prune_Broadphase : public Broadphase {
+protected:
+    void find_pairs(const std::vector<broadphase_body>& bodies) override;
+    void find_bodies(const SDL_FRect& box, std::vector<entity_handle>& out) const override; //binary searches the sorted endpoints
+
+private:
+    struct endpoint {
+        float value;
+        unsigned int proxy; //index into proxies
+        bool is_max;
+    };
+
+    struct proxy {
+        entity_handle id;
+        SDL_FRect box;
+        unsigned int last_seen; //update the body was last present in
+        size_t active_slot; //position inside the active list while sweeping
+    };
+
+    std::vector<endpoint> endpoints;
+    std::vector<proxy> proxies;
+    std::vector<unsigned int> proxy_of; //entity slot -> proxy index + 1
+    std::vector<unsigned int> free_proxies;
+    std::vector<unsigned int> active; //proxies whose interval is open during the sweep
+    unsigned int update_count = 0;
+    float max_width = 0.0f; //widest body of the last update, how far left of a query a min endpoint can be
+};
+
+//pairs every body with every other one
+class Brute_Force_Broadphase : public Broadphase {
+protected:
+    void find_pairs(const std::vector<broadphase_body>& bodies) override;
+    void find_bodies(const SDL_FRect& box, std::vector<entity_handle>& out) const override;
+
+private:
+    std::vector<broadphase_body> last_bodies; //copy of the last update, for queries
+};
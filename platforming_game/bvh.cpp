@@ -0,0 +1,53 @@
+#include "bvh.h"
+#include <algorithm>
+
+#define BVH_LEAF_SIZE 4 //bodies stored per leaf
+#define BVH_MAX_DEPTH 48 //keeps the query stack bounded
+
+void Static_BVH::build(const std::vector<broadphase_body>& bodies) {
+    clear();
+    if (bodies.empty()) return;
+
+    items = bodies;
+    nodes.reserve(items.size() * 2);
+    build_node(0, static_cast<unsigned int>(items.size()), 0);
+}
+
+unsigned int Static_BVH::build_node(unsigned int first, unsigned int count, int depth) {
+    unsigned int index = static_cast<unsigned int>(nodes.size());
+    nodes.push_back(node{});
+
+    float min_x = items[first].box.x, min_y = items[first].box.y;
+    float max_x = min_x + items[first].box.w, max_y = min_y + items[first].box.h;
+    for (unsigned int i = first + 1; i < first + count; ++i) {
+        const SDL_FRect& box = items[i].box;
+        min_x = std::min(min_x, box.x);
+        min_y = std::min(min_y, box.y);
+        max_x = std::max(max_x, box.x + box.w);
+        max_y = std::max(max_y, box.y + box.h);
+    }
+
+    nodes[index].bounds = { min_x, min_y, max_x - min_x, max_y - min_y };
+
+    if (count <= BVH_LEAF_SIZE || depth >= BVH_MAX_DEPTH) {
+        nodes[index].first = first;
+        nodes[index].count = count;
+        return index;
+    }
+
+    //median split along the longest side of the node, by box centre
+    bool split_x = (max_x - min_x) >= (max_y - min_y);
+    unsigned int half = count / 2;
+    std::nth_element(items.begin() + first, items.begin() + first + half, items.begin() + first + count,
+        [split_x](const broadphase_body& a, const broadphase_body& b) {
+            return split_x ? a.box.x + a.box.w * 0.5f < b.box.x + b.box.w * 0.5f
+                           : a.box.y + a.box.h * 0.5f < b.box.y + b.box.h * 0.5f;
+        });
+
+    build_node(first, half, depth + 1);
+    unsigned int right = build_node(first + half, count - half, depth + 1);
+
+    nodes[index].count = 0;
+    nodes[index].right = right;
+    return index;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <vector>
+#include "broadphase.h"
+
+//bounding volume hierarchy for bodies that never move (ground, walls, death planes...).
+//it is built once when the level is loaded and only queried afterwards
+class Static_BVH {
+public:
+    void build(const std::vector<broadphase_body>& bodies);
+
+    void clear() {
+        nodes.clear();
+        items.clear();
+    }
+
+    size_t size() const {
+        return items.size();
+    }
+
+    //calls fn(const broadphase_body&) for every stored body whose box overlaps `box`
+    template<class Fn>
+    void query(const SDL_FRect& box, Fn&& fn) const {
+        if (nodes.empty()) return;
+
+        unsigned int stack[64];
+        int top = 0;
+        stack[top++] = 0;
+
+        while (top > 0) {
+            const node& n = nodes[stack[--top]];
+            if (!overlaps(n.bounds, box)) continue;
+
+            if (n.count > 0) {
+                for (unsigned int i = n.first; i < n.first + n.count; ++i) {
+                    if (overlaps(items[i].box, box)) fn(items[i]);
+                }
+                continue;
+            }
+
+            //children of an inner node: the left one is stored right after it
+            unsigned int index = static_cast<unsigned int>(&n - nodes.data());
+            stack[top++] = n.right;
+            stack[top++] = index + 1;
+        }
+    }
+
+private:
+    struct node {
+        SDL_FRect bounds;
+        unsigned int first; //first item of a leaf
+        unsigned int count; //items in a leaf, 0 for inner nodes
+        unsigned int right; //right child of an inner node
+    };
+
+    static inline bool overlaps(const SDL_FRect& a, const SDL_FRect& b) {
+        return a.x <= b.x + b.w && b.x <= a.x + a.w && a.y <= b.y + b.h && b.y <= a.y + a.h;
+    }
+
+    unsigned int build_node(unsigned int first, unsigned int count, int depth);
+
+    std::vector<node> nodes;
+    std::vector<broadphase_body> items;
+};
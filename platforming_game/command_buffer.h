@@ -0,0 +1,111 @@
+#pragma once
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include "entity_handle.h"
+
+//included from entity.h, after the components namespace
+
+struct entity_manager;
+
+//defined in job_system.cpp: pool worker running the caller (0 outside the pool) and the scheduler
+//index of the system being run (0 outside the scheduler)
+unsigned int current_worker_index();
+unsigned int current_system_index();
+
+#define PROVISIONAL_ENTITY_BIT 0x80000000u //set in the generation of handles returned by command_buffer::create_entity
+
+//records structural changes (create, delete, add component, remove component) instead of applying
+//them, so systems can run in parallel and iterate views while "mutating" the world. every thread
+//records into its own buffer and the entity_manager plays them all back at the sync points between
+//systems. playback is sorted by (system, sort key, recording order) so the result doesn't depend on
+//which thread recorded what: loops should set the sort key to the entity they are processing
+class command_buffer {
+public:
+    //returns a provisional handle, usable with the other commands of this buffer until playback.
+    //its index counts the entities created by the buffer and its generation holds the buffer
+    entity_handle create_entity() {
+        entity_handle provisional{ created++, PROVISIONAL_ENTITY_BIT | owner };
+        record(command_type::CREATE, provisional, -1, nullptr, 0, nullptr);
+        return provisional;
+    }
+
+    void delete_entity(entity_handle id) {
+        record(command_type::DELETE, id, -1, nullptr, 0, nullptr);
+    }
+
+    //assigns the component at playback and copies `value` into it
+    template<class T>
+    void add_component(entity_handle id, const T& value = T()) {
+        static_assert(std::is_trivially_copyable<T>::value, "components must be trivially copyable");
+        record(command_type::ADD, id, components::get_id<T>(), &value, sizeof(T), &assign<T>);
+    }
+
+    template<class T>
+    void remove_component(entity_handle id) {
+        record(command_type::REMOVE, id, components::get_id<T>(), nullptr, 0, &unassign<T>);
+    }
+
+    //commands recorded from now on are played back in the order of this key
+    void set_sort_key(unsigned long long key) {
+        sort_key = key;
+    }
+
+    bool empty() const {
+        return commands.empty();
+    }
+
+private:
+    friend struct entity_manager;
+
+    enum class command_type : unsigned char {
+        CREATE,
+        DELETE,
+        ADD,
+        REMOVE
+    };
+
+    using apply_function = void (*)(entity_manager&, entity_handle, const void*);
+
+    struct command {
+        unsigned int system;
+        unsigned long long sort_key;
+        unsigned int sequence;
+        command_type type;
+        int component_id;
+        entity_handle entity;
+        size_t data_offset;
+        apply_function apply;
+    };
+
+    template<class T>
+    static void assign(entity_manager& em, entity_handle id, const void* data);
+
+    template<class T>
+    static void unassign(entity_manager& em, entity_handle id, const void*);
+
+    void record(command_type type, entity_handle id, int component_id, const void* value, size_t size, apply_function apply) {
+        size_t offset = data.size();
+        if (size > 0) {
+            data.resize(offset + size);
+            std::memcpy(data.data() + offset, value, size);
+        }
+
+        commands.push_back(command{ current_system_index(), sort_key, static_cast<unsigned int>(commands.size()),
+            type, component_id, id, offset, apply });
+    }
+
+    void clear() {
+        commands.clear();
+        data.clear();
+        created = 0;
+        sort_key = 0;
+    }
+
+    unsigned int owner = 0; //index of the buffer inside the entity_manager
+    std::vector<entity_handle> created_ids; //real handles of the provisional ones, filled during playback
+    unsigned int created = 0;
+    unsigned long long sort_key = 0;
+    std::vector<command> commands;
+    std::vector<char> data; //component values of the ADD commands
+};
@@ -0,0 +1,151 @@
+#include "component_schema.h"
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+    template<class T>
+    component_schema make_schema(const char* name, std::vector<component_field> fields) {
+        component_schema schema;
+        schema.name = name;
+        schema.component_id = components::get_id<T>();
+        schema.size = sizeof(T);
+        schema.alignment = alignof(T);
+        schema.fields = std::move(fields);
+
+        T value{};
+        schema.defaults.resize(sizeof(T));
+        std::memcpy(schema.defaults.data(), &value, sizeof(T));
+        return schema;
+    }
+
+    std::vector<component_schema> build_schemas() {
+        using namespace components;
+        std::vector<component_schema> schemas;
+
+        schemas.push_back(make_schema<position>("position", {
+            { "pos", offsetof(position, pos), field_type::DOUBLE, 2 },
+            { "is_grounded", offsetof(position, is_grounded), field_type::BOOL, 1 } }));
+
+        schemas.push_back(make_schema<movement>("movement", {
+            { "speed", offsetof(movement, speed), field_type::DOUBLE, 2 },
+            { "acceleration", offsetof(movement, acceleration), field_type::DOUBLE, 2 },
+            { "max_speed", offsetof(movement, max_speed), field_type::DOUBLE, 2 },
+            { "max_acceleration", offsetof(movement, max_acceleration), field_type::DOUBLE, 2 },
+            { "deceleration", offsetof(movement, deceleration), field_type::DOUBLE, 2 } }));
+
+        schemas.push_back(make_schema<render>("render", {
+            { "sprite_rect", offsetof(render, sprite_rect), field_type::FLOAT, 4 },
+            { "original_width", offsetof(render, original_width), field_type::INT, 1 },
+            { "color", offsetof(render, render_color), field_type::BYTE, 4 } }));
+
+        schemas.push_back(make_schema<gravity>("gravity", {
+            { "falling_strength", offsetof(gravity, falling_strength), field_type::DOUBLE, 1 } }));
+
+        schemas.push_back(make_schema<jump>("jump", {
+            { "jump_strength", offsetof(jump, jump_strength), field_type::DOUBLE, 1 } }));
+
+        schemas.push_back(make_schema<input>("input", {
+            { "move_left", offsetof(input, move_left), field_type::UINT, 1 },
+            { "move_right", offsetof(input, move_right), field_type::UINT, 1 },
+            { "jump", offsetof(input, jump), field_type::UINT, 1 },
+            { "crouch", offsetof(input, crouch), field_type::UINT, 1 } }));
+
+        schemas.push_back(make_schema<collision>("collision", {
+            { "hitbox", offsetof(collision, hitbox), field_type::FLOAT, 4 },
+            { "is_rigid", offsetof(collision, is_rigid), field_type::BOOL, 1 } }));
+
+        schemas.push_back(make_schema<health>("health", {
+            { "max_health", offsetof(health, max_health), field_type::INT, 1 },
+            { "current_health", offsetof(health, current_health), field_type::INT, 1 },
+            { "i_frames", offsetof(health, i_frames), field_type::INT, 1 } }));
+
+        schemas.push_back(make_schema<damage>("damage", {
+            { "damage_amount", offsetof(damage, damage_amount), field_type::INT, 1 } }));
+
+        schemas.push_back(make_schema<regeneration>("regeneration", {
+            { "regen_amount", offsetof(regeneration, regen_amount), field_type::INT, 1 },
+            { "interval", offsetof(regeneration, interval), field_type::DOUBLE, 1 } }));
+
+        schemas.push_back(make_schema<thorns>("thorns", {
+            { "damage", offsetof(thorns, damage), field_type::INT, 1 },
+            { "interval", offsetof(thorns, interval), field_type::DOUBLE, 1 } }));
+
+        return schemas;
+    }
+}
+
+const component_field* component_schema::find_field(const std::string& field_name) const {
+    for (auto& field : fields) {
+        if (field_name == field.name) return &field;
+    }
+    return nullptr;
+}
+
+const std::vector<component_schema>& component_schemas() {
+    static const std::vector<component_schema> schemas = build_schemas();
+    return schemas;
+}
+
+const component_schema* find_schema(const std::string& name) {
+    for (auto& schema : component_schemas()) {
+        if (schema.name == name) return &schema;
+    }
+    return nullptr;
+}
+
+bool parse_field(const component_field& field, const std::string& text, unsigned char* component) {
+    const char* cursor = text.c_str();
+    unsigned char* target = component + field.offset;
+
+    for (int i = 0; i < field.count; ++i) {
+        if (i > 0) {
+            if (*cursor != ',') return false;
+            ++cursor;
+        }
+
+        char* end = nullptr;
+        switch (field.type) {
+        case field_type::DOUBLE: {
+            double value = std::strtod(cursor, &end);
+            std::memcpy(target + i * sizeof(double), &value, sizeof(double));
+            break;
+        }
+        case field_type::FLOAT: {
+            float value = std::strtof(cursor, &end);
+            std::memcpy(target + i * sizeof(float), &value, sizeof(float));
+            break;
+        }
+        case field_type::INT: {
+            int value = static_cast<int>(std::strtol(cursor, &end, 10));
+            std::memcpy(target + i * sizeof(int), &value, sizeof(int));
+            break;
+        }
+        case field_type::UINT: {
+            unsigned int value = static_cast<unsigned int>(std::strtoul(cursor, &end, 10));
+            std::memcpy(target + i * sizeof(unsigned int), &value, sizeof(unsigned int));
+            break;
+        }
+        case field_type::BOOL: {
+            bool value;
+            if (std::strncmp(cursor, "true", 4) == 0) { value = true; end = const_cast<char*>(cursor) + 4; }
+            else if (std::strncmp(cursor, "false", 5) == 0) { value = false; end = const_cast<char*>(cursor) + 5; }
+            else if (*cursor == '1' || *cursor == '0') { value = *cursor == '1'; end = const_cast<char*>(cursor) + 1; }
+            else return false;
+            std::memcpy(target + i * sizeof(bool), &value, sizeof(bool));
+            break;
+        }
+        case field_type::BYTE: {
+            unsigned long value = std::strtoul(cursor, &end, 0);
+            if (value > 0xFF) return false;
+            target[i] = static_cast<unsigned char>(value);
+            break;
+        }
+        }
+
+        if (end == cursor) return false;
+        cursor = end;
+    }
+
+    return *cursor == '\0';
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "entity.h"
+
+enum class field_type {
+    DOUBLE,
+    FLOAT,
+    INT,
+    UINT,
+    BOOL,
+    BYTE //color channels
+};
+
+//a named member of a component, `count` values of `type` stored one after the other
+struct component_field {
+    const char* name;
+    size_t offset;
+    field_type type;
+    int count;
+};
+
+//what the level loaders know about a component: its name in level files, its layout and the
+//value it has right after assign_component
+struct component_schema {
+    std::string name;
+    int component_id;
+    size_t size;
+    size_t alignment;
+    std::vector<component_field> fields;
+    std::vector<unsigned char> defaults;
+
+    const component_field* find_field(const std::string& field_name) const;
+};
+
+//every component a level file can use, gameplay state like asleep isn't in here
+const std::vector<component_schema>& component_schemas();
+const component_schema* find_schema(const std::string& name);
+
+//parses `text` (comma separated values) into the field inside `component`, false if it doesn't fit
+bool parse_field(const component_field& field, const std::string& text, unsigned char* component);
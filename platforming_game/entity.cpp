@@ -12,6 +12,5 @@ namespace components {
     int damage::id = get_id<damage>();
     int regeneration::id = get_id<regeneration>();
     int thorns::id = get_id<thorns>();
-    int pending_damage::id = get_id<pending_damage>();
-    int invincibility::id = get_id<invincibility>();
+    int asleep::id = get_id<asleep>();
 }
\ No newline at end of file
@@ -1,10 +1,22 @@
 #pragma once
 #include <SDL3/SDL.h>
+#include <array>
 #include <bitset>
-#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <type_traits>
 #include <vector>
 
 #define MAX_COMPONENTS 32
+#define COMPONENT_CHUNK_SIZE 256 //components stored per chunk of a component_pool
+#define SPARSE_PAGE_SIZE 1024 //entity slots covered by each page of a component_pool sparse index
+
+#include "entity_handle.h"
+#include "logger.h"
+#include "timer_wheel.h"
+#include "archetype.h"
+#include "query.h"
 
 namespace types {
     template<typename T>
@@ -12,6 +24,15 @@ namespace types {
         T x;
         T y;
     };
+
+    //part of a Texture_Atlas page holding one image, uvs are normalized
+    struct atlas_region {
+        int page = -1; //-1 when there is no image, the entity is drawn as a colored rect
+        float u0 = 0.0f;
+        float v0 = 0.0f;
+        float u1 = 0.0f;
+        float v1 = 0.0f;
+    };
 }
 
 enum class collision_types {
@@ -33,6 +54,8 @@ namespace components {
         int max_health = 100;
         int current_health = 100;
         int i_frames = 0; //invinciblity frames after receiving damage
+        bool invincible = false; //damage is ignored until the i-frames timer fires
+        timer_handle iframes_timer;
     };
 
     struct damage {
@@ -40,30 +63,26 @@ namespace components {
         int damage_amount;
     };
 
-    struct pending_damage {
-        static int id;
-        int pending_amount = 0;
-    };
-
+    //heals regen_amount every interval seconds, through a periodic timer started when the component is assigned
     struct regeneration{
         static int id;
         int regen_amount = 0;
+        double interval = 1.0;
+        timer_handle timer;
     };
 
+    //damages its own entity every interval seconds, same as regeneration
     struct thorns {
         static int id;
         int damage;
-    };
-
-    struct invincibility {
-        static int id;
-        double max_duration = 0.0;
-        double remaining_time = 0.0;
+        double interval = 1.0;
+        timer_handle timer;
     };
 
     struct position {
         static int id; // Declaration
         types::Vec2<double> pos{ 0,0 };
+        types::Vec2<double> previous_pos{ 0,0 }; //pos before the last simulation step, rendering interpolates between both
         bool is_grounded = false;
     };
 
@@ -75,13 +94,16 @@ namespace components {
         types::Vec2<double> max_acceleration{ 0,0 };
 
         types::Vec2<double> deceleration{ 10.0,10.0 };
+
+        int idle_frames = 0; //consecutive frames spent below the sleep speed threshold
     };
 
     struct render {
         static int id; // Declaration
         SDL_FRect sprite_rect{ 0,0,10,10 };
         int original_width = 10;
-        SDL_Color render_color = { 0xFF,0x00,0x00,0xFF };
+        SDL_Color render_color = { 0xFF,0x00,0x00,0xFF }; //fill color without a sprite, tint with one
+        types::atlas_region sprite;
     };
 
     struct physics {
@@ -115,95 +137,656 @@ namespace components {
         SDL_FRect hitbox;
         bool is_rigid = false;
     };
+
+    //tag of dynamic bodies that stopped moving, they are skipped by movement and collisions until something touches them
+    struct asleep {
+        static int id;
+    };
 }
 
+//events sent between systems through entity_manager::events<T>()
+struct damage_event {
+    entity_handle target;
+    entity_handle source; //null for damage that doesn't come from an entity, like tiles
+    int amount;
+};
+
+struct heal_event {
+    entity_handle target;
+    entity_handle source;
+    int amount;
+};
+
+struct entity_manager;
+
+//components of one type for a set of entities, packed, as a loader reads them
+struct component_column {
+    int component_id;
+    size_t size;
+    size_t alignment;
+    size_t count;
+    const std::uint32_t* rows; //entity of every value, an index into the entities being filled
+    const unsigned char* values; //count components of `size` bytes
+};
+
+//runs with the entity whose component was just assigned (value in place) or is about to be removed.
+//hooks must not assign or remove components or delete entities themselves
+using component_hook = void (*)(void* context, entity_manager& em, entity_handle id);
+
+struct component_hooks {
+    component_hook on_assign = nullptr;
+    component_hook on_remove = nullptr;
+    void* context = nullptr;
+};
+
+//slot of the entity_manager, live or dead
 struct entity {
-    unsigned long long id;
     std::bitset<MAX_COMPONENTS> mask; //bitmask to identify components
+    std::uint32_t generation = 0; //handles to the slot are alive while their generation matches this one
+    std::uint32_t next_free = ENTITY_NULL_INDEX; //next dead slot of the free list while this one is dead
 };
 
+//sparse set storage for a single component type.
+//components are kept densely packed in fixed-size chunks so growing the pool never moves
+//existing components, the owners array mirrors the dense slots and the sparse index maps an
+//entity slot to its dense slot. removal swaps the last component into the freed slot, so only
+//a pointer to the last component of the pool can be invalidated by remove()
 struct component_pool {
-   component_pool(size_t e_size) : element_size(e_size) {
-        component_array = new char[element_size * MAX_COMPONENTS];
-   }
+    static constexpr size_t chunk_elements = COMPONENT_CHUNK_SIZE;
+    static constexpr size_t page_entries = SPARSE_PAGE_SIZE;
 
-   ~component_pool() {
-       delete[] component_array;
-   }
+    component_pool(size_t e_size) : element_size(e_size) {}
+
+    ~component_pool() {
+        for (char* chunk : chunks) {
+            delete[] chunk;
+        }
+    }
 
-   inline void* get(int id) {
-       return component_array + id * element_size;
-   }
+    component_pool(const component_pool&) = delete;
+    component_pool& operator=(const component_pool&) = delete;
+
+    inline bool contains(std::uint32_t index) const {
+        return slot_of(index) != 0;
+    }
+
+    inline void* get(std::uint32_t index) {
+        size_t slot = slot_of(index);
+        if (slot == 0) return nullptr;
+        return at(slot - 1);
+    }
+
+    //address of the component stored in a dense slot
+    inline void* at(size_t slot) {
+        return chunks[slot / chunk_elements] + (slot % chunk_elements) * element_size;
+    }
+
+    //returns the storage for the component of an entity, appending a new slot if it has none
+    void* insert(std::uint32_t index) {
+        size_t slot = slot_of(index);
+        if (slot != 0) return at(slot - 1);
+
+        if (owners.size() == chunks.size() * chunk_elements) {
+            chunks.push_back(new char[element_size * chunk_elements]);
+        }
+
+        owners.push_back(index);
+        sparse_entry(index) = owners.size(); //slots are stored off by one so 0 means "no component"
+        return at(owners.size() - 1);
+    }
+
+    //appends the components of entities that don't have one yet, `values` holds them packed in the
+    //order of `indices`. the values are copied a chunk at a time instead of one slot at a time
+    void append(const std::uint32_t* indices, size_t count, const unsigned char* values) {
+        size_t first = owners.size();
+        owners.insert(owners.end(), indices, indices + count);
+
+        while (chunks.size() * chunk_elements < owners.size()) {
+            chunks.push_back(new char[element_size * chunk_elements]);
+        }
+
+        for (size_t copied = 0; copied < count;) {
+            size_t slot = first + copied;
+            size_t run = std::min(count - copied, chunk_elements - slot % chunk_elements);
+            std::memcpy(at(slot), values + copied * element_size, run * element_size);
+            copied += run;
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            sparse_entry(indices[i]) = first + i + 1;
+        }
+    }
+
+    //swap-and-pop removal, keeps the dense arrays packed
+    void remove(std::uint32_t index) {
+        size_t slot = slot_of(index);
+        if (slot == 0) return;
+
+        size_t removed = slot - 1;
+        size_t last = owners.size() - 1;
+
+        if (removed != last) {
+            std::memcpy(at(removed), at(last), element_size);
+            owners[removed] = owners[last];
+            sparse_entry(owners[removed]) = removed + 1;
+        }
+
+        owners.pop_back();
+        sparse_entry(index) = 0;
+    }
+
+    inline size_t size() const {
+        return owners.size();
+    }
 
     size_t element_size;
-    char* component_array;
+    std::vector<char*> chunks; //dense component storage, chunk_elements components per chunk
+    std::vector<std::uint32_t> owners; //entity slot owning each dense slot
+    std::vector<std::unique_ptr<size_t[]>> sparse; //paged entity slot -> dense slot + 1 index
+
+private:
+    inline size_t slot_of(std::uint32_t index) const {
+        size_t page = index / page_entries;
+        if (page >= sparse.size() || !sparse[page]) return 0;
+        return sparse[page][index % page_entries];
+    }
+
+    inline size_t& sparse_entry(std::uint32_t index) {
+        size_t page = index / page_entries;
+        if (page >= sparse.size()) {
+            sparse.resize(page + 1);
+        }
+        if (!sparse[page]) {
+            sparse[page].reset(new size_t[page_entries]()); //pages are only allocated for slots in use
+        }
+        return sparse[page][index % page_entries];
+    }
+};
+
+#include "command_buffer.h"
+#include "event_queue.h"
+
+//bitmask with the ids of the given component types
+template<class... Ts>
+std::bitset<MAX_COMPONENTS> component_mask() {
+    std::bitset<MAX_COMPONENTS> mask;
+    (mask.set(components::get_id<Ts>()), ...);
+    return mask;
+}
+
+//how the entity_manager stores components:
+//SPARSE_SET keeps one packed pool per component type, adding and removing components is cheap.
+//ARCHETYPE packs entities with the same mask together in chunks so systems can iterate whole
+//columns, but adding or removing a component moves the entity and invalidates its component pointers
+enum class storage_mode {
+    SPARSE_SET,
+    ARCHETYPE
 };
 
 struct entity_manager {
-    entity_manager() {}
+    entity_manager(storage_mode mode = storage_mode::SPARSE_SET) : mode(mode) {}
+
+    //reuses the most recently freed slot, so creating and deleting entities in bulk allocates nothing
+    entity_handle new_entity() {
+        if (free_head != ENTITY_NULL_INDEX) {
+            std::uint32_t index = free_head;
+            free_head = entities[index].next_free;
+            entities[index].next_free = ENTITY_NULL_INDEX;
+            return entity_handle{ index, entities[index].generation };
+        }
 
-    unsigned long long new_entity() {
-        if (!free_ids.empty()) {
-            unsigned long long id = free_ids.back();
-            free_ids.pop_back();
-            entities[id].mask.reset(); //reset the component mask for the reused entity
-            return id;
+        entities.push_back(entity());
+        return entity_handle{ static_cast<std::uint32_t>(entities.size() - 1), 0 };
+    }
+
+    //new_entity() `count` times, growing the slot array once for the ones the free list can't give
+    void new_entities(size_t count, std::vector<entity_handle>& out) {
+        out.resize(count);
+        size_t created = 0;
+        for (; created < count && free_head != ENTITY_NULL_INDEX; ++created) {
+            out[created] = new_entity();
+        }
+
+        size_t first = entities.size();
+        entities.resize(first + (count - created));
+        for (size_t i = first; created < count; ++i, ++created) {
+            out[created] = entity_handle{ static_cast<std::uint32_t>(i), 0 };
         }
-        entities.push_back(entity{ entities.size(), std::bitset<MAX_COMPONENTS>() });
-        return entities.back().id;
     }
 
-    void delete_entity(unsigned long long id) {
-        if (id >= entities.size() || !entities[id].mask.any()) {
+    //false for handles to deleted entities, even if their slot holds a new entity
+    inline bool is_alive(entity_handle id) const {
+        return id.index < entities.size() && entities[id.index].generation == id.generation;
+    }
+
+    void delete_entity(entity_handle id) {
+        if (!is_alive(id)) {
             return; //entity already deleted or invalid
         }
 
+        for (size_t i = 0; i < MAX_COMPONENTS; ++i) {
+            if (entities[id.index].mask.test(i) && hooks[i].on_remove) {
+                hooks[i].on_remove(hooks[i].context, *this, id);
+            }
+        }
+
+        entity& slot = entities[id.index];
+        std::bitset<MAX_COMPONENTS> removed = slot.mask;
+
         //remove all components associated with the entity
+        if (mode == storage_mode::ARCHETYPE) {
+            archetypes.remove_all(id);
+            slot.mask.reset();
+        }
+
         for (size_t i = 0; i < MAX_COMPONENTS; ++i) {
-            if (entities[id].mask.test(i)) {
-                //optionally call destructors for components if needed
-                entities[id].mask.reset(i);
+            if (slot.mask.test(i)) {
+                components_pool[i]->remove(id.index);
+                slot.mask.reset(i);
             }
         }
 
-        //mark the entity as free for reuse
-        free_ids.push_back(id);
+        for (size_t i = 0; i < MAX_COMPONENTS; ++i) {
+            if (removed.test(i)) {
+                update_queries(id, static_cast<int>(i));
+            }
+        }
 
-        std::cout << "Deleted entity: " << id << "\n";
+        //every handle to the entity dies with the generation, then the slot goes on the free list
+        slot.generation = (slot.generation + 1) & ENTITY_GENERATION_MASK;
+        slot.next_free = free_head;
+        free_head = id.index;
+
+        LOG_DEBUG("Deleted entity: {}", id.index);
     }
 
+    //nullptr if the entity isn't alive
     template<class T>
-    T* assign_component(unsigned long long id) {
+    T* assign_component(entity_handle id) {
+        //components are relocated with memcpy when the pool swaps and pops
+        static_assert(std::is_trivially_copyable<T>::value, "components must be trivially copyable");
+
         int component_id = components::get_id<T>();
+        bool added = !has_component<T>(id);
+
+        void* storage = assign_component_storage(id, component_id, sizeof(T), alignof(T));
+        if (!storage) return nullptr;
 
-        if (components_pool.size() <= component_id) {
-            components_pool.resize(component_id + 1, nullptr);
+        T* component = new (storage) T();
+        if (added) run_assign_hook(id, component_id);
+        return component;
+    }
+
+    //untyped assign for loaders copying component bytes straight into storage. returns the
+    //component memory, left as it was if the entity already had the component. the on_assign
+    //hook isn't run, callers run it with run_assign_hook once the component has its value
+    void* assign_component_storage(entity_handle id, int component_id, size_t size, size_t alignment) {
+        if (!is_alive(id)) return nullptr;
+
+        void* storage = nullptr;
+
+        if (mode == storage_mode::ARCHETYPE) {
+            archetypes.register_component(component_id, size, alignment);
+            storage = archetypes.add(id, component_id);
         }
+        else {
+            if (components_pool.size() <= static_cast<size_t>(component_id)) {
+                components_pool.resize(component_id + 1);
+            }
 
-        if (components_pool[component_id] == nullptr) {
-            components_pool[component_id] = new component_pool(sizeof(T));
+            if (!components_pool[component_id]) {
+                components_pool[component_id].reset(new component_pool(size));
+            }
+
+            storage = components_pool[component_id]->insert(id.index);
         }
 
-        T* component = new (components_pool[component_id]->get(id)) T();
+        if (!entities[id.index].mask.test(component_id)) {
+            entities[id.index].mask.set(component_id);
+            update_queries(id, component_id);
+        }
+        return storage;
+    }
 
-        entities[id].mask.set(component_id);
-        return component;
+    //bulk assign for loaders filling entities that have no components yet: every entity gets its whole mask at
+    //once, so in SPARSE_SET mode every column goes into its pool in one go and in ARCHETYPE mode every entity
+    //is placed straight into its final archetype instead of moving through one per component. the on_assign
+    //hooks run once everything is in place, column by column. falls back to assign_component_storage for
+    //entities that already have components or appear twice in a column
+    void assign_columns(const std::vector<entity_handle>& ids, const std::vector<component_column>& columns) {
+        std::bitset<MAX_COMPONENTS> loaded;
+        bool fresh = true;
+
+        for (entity_handle id : ids) {
+            fresh = fresh && is_alive(id) && entities[id.index].mask.none();
+        }
+
+        //the masks are built first, a component showing up twice for an entity takes the slow path
+        bulk_masks.assign(ids.size(), std::bitset<MAX_COMPONENTS>());
+        for (auto& column : columns) {
+            for (size_t row = 0; fresh && row < column.count; ++row) {
+                std::bitset<MAX_COMPONENTS>& mask = bulk_masks[column.rows[row]];
+                fresh = !mask.test(column.component_id);
+                mask.set(column.component_id);
+            }
+            loaded.set(column.component_id);
+        }
+
+        if (!fresh) {
+            //like assign_component: dead entities are skipped and only components the entity didn't have run their hook
+            bulk_added.clear();
+            for (auto& column : columns) {
+                for (size_t row = 0; row < column.count; ++row) {
+                    entity_handle id = ids[column.rows[row]];
+                    bool added = is_alive(id) && !entities[id.index].mask.test(column.component_id);
+
+                    void* storage = assign_component_storage(id, column.component_id, column.size, column.alignment);
+                    if (storage) std::memcpy(storage, column.values + row * column.size, column.size);
+                    bulk_added.push_back(added);
+                }
+            }
+        }
+        else if (mode == storage_mode::ARCHETYPE) {
+            for (auto& column : columns) {
+                archetypes.register_component(column.component_id, column.size, column.alignment);
+            }
+
+            for (size_t i = 0; i < ids.size(); ++i) {
+                entities[ids[i].index].mask = bulk_masks[i];
+                if (bulk_masks[i].any()) archetypes.place(ids[i], bulk_masks[i]);
+            }
+
+            for (auto& column : columns) {
+                for (size_t row = 0; row < column.count; ++row) {
+                    std::memcpy(archetypes.get(ids[column.rows[row]], column.component_id), column.values + row * column.size, column.size);
+                }
+            }
+        }
+        else {
+            for (size_t i = 0; i < ids.size(); ++i) {
+                entities[ids[i].index].mask = bulk_masks[i];
+            }
+
+            for (auto& column : columns) {
+                if (components_pool.size() <= static_cast<size_t>(column.component_id)) {
+                    components_pool.resize(column.component_id + 1);
+                }
+                if (!components_pool[column.component_id]) {
+                    components_pool[column.component_id].reset(new component_pool(column.size));
+                }
+
+                bulk_slots.resize(column.count);
+                for (size_t row = 0; row < column.count; ++row) {
+                    bulk_slots[row] = ids[column.rows[row]].index;
+                }
+                components_pool[column.component_id]->append(bulk_slots.data(), column.count, column.values);
+            }
+        }
+
+        //every query touching a loaded component sees each entity once, with its final mask
+        if (fresh) {
+            for (auto& cache : queries) {
+                if (((cache->include | cache->exclude) & loaded).none()) continue;
+                for (entity_handle id : ids) {
+                    cache->update(id, entities[id.index].mask);
+                }
+            }
+        }
+
+        size_t hook_row = 0;
+        for (auto& column : columns) {
+            for (size_t row = 0; row < column.count; ++row, ++hook_row) {
+                if (fresh || bulk_added[hook_row]) run_assign_hook(ids[column.rows[row]], column.component_id);
+            }
+        }
+    }
+
+    //untyped get, nullptr if the entity doesn't have the component
+    void* get_component_storage(entity_handle id, int component_id) {
+        if (!is_alive(id) || !entities[id.index].mask.test(component_id)) return nullptr;
+
+        if (mode == storage_mode::ARCHETYPE) {
+            return archetypes.get(id, component_id);
+        }
+        return components_pool[component_id]->get(id.index);
     }
 
     template<class T>
-    void remove_component(unsigned long long id) {
+    void remove_component(entity_handle id) {
         int component_id = components::get_id<T>();
-        entities[id].mask.reset(component_id);
+        if (!is_alive(id) || !entities[id.index].mask.test(component_id)) return;
+
+        if (hooks[component_id].on_remove) {
+            hooks[component_id].on_remove(hooks[component_id].context, *this, id);
+        }
+
+        if (mode == storage_mode::ARCHETYPE) {
+            archetypes.remove(id, component_id);
+        }
+        else {
+            components_pool[component_id]->remove(id.index);
+        }
+
+        entities[id.index].mask.reset(component_id);
+        update_queries(id, component_id);
     }
 
+    //nullptr if the entity doesn't have the component or isn't alive
     template<class T>
-    T* get_component(unsigned long long id) {
+    T* get_component(entity_handle id) {
         int component_id = components::get_id<T>();
-        if (!entities[id].mask.test(component_id)) return nullptr;
-        return static_cast<T*>(components_pool[component_id]->get(id));
+        if (!is_alive(id) || !entities[id.index].mask.test(component_id)) return nullptr;
+
+        if (mode == storage_mode::ARCHETYPE) {
+            return static_cast<T*>(archetypes.get(id, component_id));
+        }
+        return static_cast<T*>(components_pool[component_id]->get(id.index));
+    }
+
+    //one pair of hooks per component type, they only see the components assigned and removed after they are set
+    template<class T>
+    void set_component_hooks(component_hook on_assign, component_hook on_remove, void* context) {
+        hooks[components::get_id<T>()] = component_hooks{ on_assign, on_remove, context };
+    }
+
+    void run_assign_hook(entity_handle id, int component_id) {
+        if (hooks[component_id].on_assign) {
+            hooks[component_id].on_assign(hooks[component_id].context, *this, id);
+        }
+    }
+
+    //false for entities that aren't alive
+    template<class T>
+    bool has_component(entity_handle id) const {
+        return is_alive(id) && entities[id.index].mask.test(components::get_id<T>());
+    }
+
+    //iterates the archetype storage chunk by chunk, only available in ARCHETYPE mode
+    template<class Fn>
+    void for_each_chunk(const std::bitset<MAX_COMPONENTS>& required, const std::bitset<MAX_COMPONENTS>& excluded, Fn&& fn) {
+        archetypes.for_each_chunk(required, excluded, std::forward<Fn>(fn));
+    }
+
+    //cached list of the entities having every plain component in Ts, none of the query::exclude<T>
+    //ones, and optionally the query::optional<T> ones. the match list is built once and then kept up
+    //to date on every assign/remove, so iterating a view only touches the entities it matches
+    template<class... Ts>
+    basic_view<Ts...> view() {
+        static_assert((query::term<Ts>::required || ...), "a view needs at least one required component");
+
+        std::bitset<MAX_COMPONENTS> include;
+        std::bitset<MAX_COMPONENTS> exclude;
+
+        int ids[] = { components::get_id<typename query::term<Ts>::component>()... };
+        bool required[] = { query::term<Ts>::required... };
+        bool excluded[] = { query::term<Ts>::excluded... };
+
+        for (size_t i = 0; i < sizeof...(Ts); ++i) {
+            if (required[i]) include.set(ids[i]);
+            if (excluded[i]) exclude.set(ids[i]);
+        }
+
+        return basic_view<Ts...>(*this, find_query(include, exclude));
+    }
+
+    //command buffer of the calling thread. structural changes recorded in it are applied by apply_commands(),
+    //which the System_Scheduler calls between stages. set_worker_count() has to cover every pool worker
+    command_buffer& deferred() {
+        return command_buffers[current_worker_index()];
+    }
+
+    //one command buffer and one buffer per event queue for every thread that may record commands or send events
+    void set_worker_count(unsigned int count) {
+        if (count == 0) count = 1;
+        command_buffers.resize(count);
+        for (unsigned int i = 0; i < count; ++i) {
+            command_buffers[i].owner = i;
+        }
+
+        for (auto& queue : event_queues) {
+            if (queue) queue->set_worker_count(count);
+        }
+    }
+
+    //queue of an event type, created the first time it is asked for. systems look their queues up
+    //once when they are built and keep the reference, the queue lives as long as the entity_manager
+    template<class T>
+    event_queue<T>& events() {
+        int id = event_type_id<T>();
+        if (event_queues.size() <= static_cast<size_t>(id)) {
+            event_queues.resize(id + 1);
+        }
+        if (!event_queues[id]) {
+            event_queues[id] = std::make_unique<event_queue<T>>();
+            event_queues[id]->set_worker_count(static_cast<unsigned int>(command_buffers.size()));
+        }
+        return static_cast<event_queue<T>&>(*event_queues[id]);
+    }
+
+    //events sent since the last call become readable, the ones readable until now are dropped.
+    //the System_Scheduler calls it once per run, after advancing the timers and before the first stage
+    void swap_events() {
+        for (auto& queue : event_queues) {
+            if (queue) queue->swap();
+        }
+    }
+
+    //plays back every recorded command, sorted by (system, sort key, recording order)
+    void apply_commands() {
+        pending_commands.clear();
+        for (auto& buffer : command_buffers) {
+            for (auto& c : buffer.commands) {
+                pending_commands.push_back(recorded_command{ &buffer, &c });
+            }
+        }
+        if (pending_commands.empty()) return;
+
+        std::sort(pending_commands.begin(), pending_commands.end(), [](const recorded_command& a, const recorded_command& b) {
+            if (a.cmd->system != b.cmd->system) return a.cmd->system < b.cmd->system;
+            if (a.cmd->sort_key != b.cmd->sort_key) return a.cmd->sort_key < b.cmd->sort_key;
+            if (a.buffer->owner != b.buffer->owner) return a.buffer->owner < b.buffer->owner;
+            return a.cmd->sequence < b.cmd->sequence;
+        });
+
+        //entities are created first so later commands can refer to their provisional handles
+        for (auto& buffer : command_buffers) {
+            buffer.created_ids.clear();
+        }
+        for (auto& recorded : pending_commands) {
+            if (recorded.cmd->type == command_buffer::command_type::CREATE) {
+                recorded.buffer->created_ids.push_back(new_entity());
+            }
+        }
+
+        for (auto& recorded : pending_commands) {
+            const auto& c = *recorded.cmd;
+            if (c.type == command_buffer::command_type::CREATE) continue;
+
+            entity_handle id = c.entity;
+            if (id.generation & PROVISIONAL_ENTITY_BIT) {
+                id = command_buffers[id.generation & ~PROVISIONAL_ENTITY_BIT].created_ids[id.index];
+            }
+
+            //commands on entities deleted earlier in the same playback (or before it) are dropped
+            if (!is_alive(id)) continue;
+
+            if (c.type == command_buffer::command_type::DELETE) {
+                delete_entity(id);
+            }
+            else {
+                c.apply(*this, id, recorded.buffer->data.data() + c.data_offset);
+            }
+        }
+
+        for (auto& buffer : command_buffers) {
+            buffer.clear();
+        }
     }
 
-    std::vector<entity> entities;
-    std::vector<component_pool*> components_pool;
-    std::vector<unsigned long long> free_ids; // List of free entity IDs for reuse
-};
\ No newline at end of file
+    storage_mode mode;
+    std::vector<entity> entities; //indexed by entity_handle::index
+    std::vector<std::unique_ptr<component_pool>> components_pool;
+    archetype_storage archetypes;
+    std::uint32_t free_head = ENTITY_NULL_INDEX; //first dead slot, the rest are linked through entity::next_free
+    Timer_Wheel timers; //timed effects of the world, the System_Scheduler advances it before every run
+
+private:
+    struct recorded_command {
+        command_buffer* buffer;
+        const command_buffer::command* cmd;
+    };
+
+    query_cache* find_query(const std::bitset<MAX_COMPONENTS>& include, const std::bitset<MAX_COMPONENTS>& exclude) {
+        for (auto& cache : queries) {
+            if (cache->include == include && cache->exclude == exclude) {
+                return cache.get();
+            }
+        }
+
+        queries.push_back(std::make_unique<query_cache>(include, exclude));
+        query_cache* cache = queries.back().get();
+
+        //only the first request for a query scans the entities, dead slots have no components
+        for (size_t i = 0; i < entities.size(); ++i) {
+            cache->update(entity_handle{ static_cast<std::uint32_t>(i), entities[i].generation }, entities[i].mask);
+        }
+
+        for (size_t i = 0; i < MAX_COMPONENTS; ++i) {
+            if (include.test(i) || exclude.test(i)) {
+                queries_by_component[i].push_back(cache);
+            }
+        }
+
+        return cache;
+    }
+
+    inline void update_queries(entity_handle id, int component_id) {
+        for (query_cache* cache : queries_by_component[component_id]) {
+            cache->update(id, entities[id.index].mask);
+        }
+    }
+
+    std::vector<std::unique_ptr<query_cache>> queries;
+    std::array<std::vector<query_cache*>, MAX_COMPONENTS> queries_by_component; //queries to refresh when a component changes
+
+    std::vector<command_buffer> command_buffers = std::vector<command_buffer>(1);
+    std::vector<recorded_command> pending_commands;
+    std::vector<std::unique_ptr<event_queue_base>> event_queues; //indexed by event_type_id
+    std::vector<std::bitset<MAX_COMPONENTS>> bulk_masks; //scratch of assign_columns
+    std::vector<bool> bulk_added; //per row of assign_columns' slow path, whether the component was new
+    std::vector<std::uint32_t> bulk_slots;
+    std::array<component_hooks, MAX_COMPONENTS> hooks{};
+};
+
+template<class T>
+void command_buffer::assign(entity_manager& em, entity_handle id, const void* data) {
+    //the hook runs once the recorded value is in place
+    bool added = !em.has_component<T>(id);
+    std::memcpy(em.assign_component_storage(id, components::get_id<T>(), sizeof(T), alignof(T)), data, sizeof(T));
+    if (added) em.run_assign_hook(id, components::get_id<T>());
+}
+
+template<class T>
+void command_buffer::unassign(entity_manager& em, entity_handle id, const void*) {
+    em.remove_component<T>(id);
+}
\ No newline at end of file
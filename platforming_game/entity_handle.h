@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+
+#define ENTITY_NULL_INDEX 0xFFFFFFFFu //index of handles that don't refer to any entity
+#define ENTITY_GENERATION_MASK 0x7FFFFFFFu //generations wrap within 31 bits, the top bit marks provisional handles
+
+//refers to an entity: the slot it lives in plus the generation that slot had when the entity was created.
+//deleting an entity bumps the generation of its slot, so handles kept to it stop being alive instead of
+//referring to the next entity created in the same slot
+struct entity_handle {
+    std::uint32_t index = ENTITY_NULL_INDEX;
+    std::uint32_t generation = 0;
+};
+
+inline bool operator==(entity_handle a, entity_handle b) {
+    return a.index == b.index && a.generation == b.generation;
+}
+
+inline bool operator!=(entity_handle a, entity_handle b) {
+    return !(a == b);
+}
+
+//ordered by slot first, so sorted handles follow the order of the entity storage
+inline bool operator<(entity_handle a, entity_handle b) {
+    if (a.index != b.index) return a.index < b.index;
+    return a.generation < b.generation;
+}
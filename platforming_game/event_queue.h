@@ -0,0 +1,60 @@
+#pragma once
+#include <vector>
+
+//included from entity.h, after command_buffer.h
+
+//ids of event types, given out in order of first use
+inline int next_event_type_id() {
+    static int counter = 0;
+    return counter++;
+}
+
+template<class T>
+int event_type_id() {
+    static int id = next_event_type_id();
+    return id;
+}
+
+class event_queue_base {
+public:
+    virtual ~event_queue_base() = default;
+
+    virtual void set_worker_count(unsigned int count) = 0;
+    virtual void swap() = 0;
+};
+
+//stream of events of one type, double buffered per step: events sent during a step are read during
+//the next one, all of them from one contiguous array. every pool worker sends into its own buffer so
+//systems running in parallel send without locking, and reading never races with sending.
+//swap() concatenates the worker buffers in worker order, readers shouldn't depend on the order of
+//events sent from different threads
+template<class T>
+class event_queue : public event_queue_base {
+public:
+    void send(const T& event) {
+        sending[current_worker_index()].push_back(event);
+    }
+
+    //events sent during the previous step
+    const std::vector<T>& read() const {
+        return readable;
+    }
+
+    void set_worker_count(unsigned int count) override {
+        sending.resize(count);
+    }
+
+    //drops the events that were readable and makes the ones sent since the last swap readable.
+    //buffers keep their capacity, a steady stream of events allocates nothing
+    void swap() override {
+        readable.clear();
+        for (auto& buffer : sending) {
+            readable.insert(readable.end(), buffer.begin(), buffer.end());
+            buffer.clear();
+        }
+    }
+
+private:
+    std::vector<std::vector<T>> sending = std::vector<std::vector<T>>(1);
+    std::vector<T> readable;
+};
@@ -1,157 +1,84 @@
 #include "game.h"
 
-Game::Game() : is_running(true), window(nullptr), renderer(nullptr), collision(em), movement_system(em, input, collision), health_system(em) {
+Game::Game(simulation_settings settings, std::string level_path) : is_running(true), paused(false), frame_rate(DEFAULT_FRAME_RATE), start_time(SDL_GetPerformanceCounter()), level_path(std::move(level_path)), window(nullptr), renderer(nullptr), simulation(settings), render_system(simulation.em), assets(render_system.get_atlas()) {
 	init();
 }
 
 void Game::init() {
 	if (SDL_Init(SDL_INIT_VIDEO) == 0) {
-		std::cerr << "Could not initialize SDL: " << SDL_GetError() << "\n";
+		LOG_ERROR("Could not initialize SDL: {}", SDL_GetError());
 		is_running = false;
 		return;
 	}
 
 	window = SDL_CreateWindow("game", 900, 900, SDL_WINDOW_RESIZABLE);
 	if (!window) {
-		std::cerr << "Could not create SDL_Window: " << SDL_GetError() << "\n";
+		LOG_ERROR("Could not create SDL_Window: {}", SDL_GetError());
 		is_running = false;
 		return;
 	}
 
 	renderer = SDL_CreateRenderer(window, nullptr);
 	if (!renderer) {
-		std::cerr << "Could not create SDL_Renderer: " << SDL_GetError() << "\n";
+		LOG_ERROR("Could not create SDL_Renderer: {}", SDL_GetError());
 		is_running = false;
 		return;
 	}
 
-	create_player();
-	create_enemy();
-
-	//ground doesn't need movement or input components, only collisions and renders
-	unsigned long long ground_id = em.new_entity();
-	em.assign_component<components::position>(ground_id);
-	em.assign_component<components::collision>(ground_id);
-	em.assign_component<components::render>(ground_id);
-
-	auto* ground_position = em.get_component<components::position>(ground_id);
-	ground_position->pos.x = -500;
-	ground_position->pos.y = 600;
-
-	auto* ground_render = em.get_component<components::render>(ground_id);
-	ground_render->sprite_rect = { static_cast<float>(ground_position->pos.x), static_cast<float>(ground_position->pos.y), 1900,200};
-	ground_render->original_width = 1900;
-	ground_render->render_color = {0x00,0x00,0xFF,0xFF};
-
-	auto* ground_collision = em.get_component<components::collision>(ground_id);
-	ground_collision->hitbox = ground_render->sprite_rect;
-	ground_collision->is_rigid = true;
-
-	unsigned long long wall_id = em.new_entity();
-	em.assign_component<components::position>(wall_id);
-	em.assign_component<components::collision>(wall_id);
-	em.assign_component<components::render>(wall_id);
-
-	auto* wall_position = em.get_component<components::position>(wall_id);
-	wall_position->pos.x = 800;
-	wall_position->pos.y = 0;
-
-	auto* wall_render = em.get_component<components::render>(wall_id);
-	wall_render->sprite_rect = { static_cast<float>(wall_position->pos.x), static_cast<float>(wall_position->pos.y), 200,555 };
-	wall_render->original_width = 200;
-	wall_render->render_color = { 0x00,0xFF,0xFF,0xFF };
-
-	auto* wall_collision = em.get_component<components::collision>(wall_id);
-	wall_collision->hitbox = wall_render->sprite_rect;
-	wall_collision->is_rigid = true;
-
-	unsigned long long death_ground = em.new_entity();
-	em.assign_component<components::collision>(death_ground);
-	em.assign_component<components::damage>(death_ground);
-	auto* death_collision = em.get_component<components::collision>(death_ground);
-	death_collision->hitbox = { -1000, 800, 5000, 200 };
-	auto* death_damage = em.get_component<components::damage>(death_ground);
-	death_damage->damage_amount = 20;
-
-	death_collision->is_rigid = true;
-
-	std::cout << "Death ID: " << death_ground << "\n";
+	//pace frames to the display, the simulation always steps at SIMULATION_RATE
+	const SDL_DisplayMode* display_mode = SDL_GetCurrentDisplayMode(SDL_GetDisplayForWindow(window));
+	if (display_mode && display_mode->refresh_rate > 0.0f) {
+		frame_rate = display_mode->refresh_rate;
+	}
+
+	if (!simulation.load_level(level_path)) {
+		simulation.create_default_level();
+	}
+	render_system.set_tilemap(&simulation.tilemap);
+	render_system.set_dynamic_index(&simulation.collision.get_broadphase());
+	render_system.build_static_index();
+
+	//decoded in the background, the first frames are drawn with colored rects until they are ready
+	request_sprites();
+
+	simulation.input.assign_action(PROFILER_OVERLAY_KEY, [this]() {
+		profiler_overlay = !profiler_overlay;
+		Profiler::get().set_enabled(profiler_overlay);
+	});
 }
 
-void Game::create_player() {
-	unsigned long long player_id = em.new_entity();
-	em.assign_component<components::position>(player_id);
-	em.assign_component<components::movement>(player_id);
-	em.assign_component<components::render>(player_id);
-	em.assign_component<components::gravity>(player_id);
-	em.assign_component<components::input>(player_id);
-	em.assign_component<components::collision>(player_id);
-	em.assign_component<components::health>(player_id);
-	em.assign_component<components::jump>(player_id);
-
-	auto* player_position = em.get_component<components::position>(player_id);
-	player_position->pos = { 10.0,10.0 };
-
-	auto* player_movement = em.get_component<components::movement>(player_id);
-	player_movement->speed = { 0.0,0.0 };
-	player_movement->acceleration = { 2.0f,4.0f };
-
-	player_movement->max_speed = { 15.0,50.0 };
-	player_movement->max_acceleration = { 5.0,5.0 };
-
-	auto* player_sprite = em.get_component<components::render>(player_id);
-	player_sprite->sprite_rect = { static_cast<float>(player_position->pos.x), static_cast<float>(player_position->pos.y), 50,50 };
-	player_sprite->original_width = 50;
-	player_sprite->render_color = { 0x00,0xFF,0x00,0xFF };
-
-	auto* player_collision = em.get_component<components::collision>(player_id);
-	player_collision->hitbox.x = player_position->pos.x;
-	player_collision->hitbox.y = player_position->pos.y;
-	player_collision->hitbox.w = player_sprite->sprite_rect.w;
-	player_collision->hitbox.h = player_sprite->sprite_rect.h;
-
-	auto* player_health = em.get_component <components::health>(player_id);
-	player_health->max_health = 100;
-	player_health->current_health = player_health->max_health;
-	player_health->i_frames = 5;
+void Game::request_sprites() {
+	player_sprite = assets.load_image("player", "assets/player.png");
+	enemy_sprite = assets.load_image("enemy", "assets/enemy.png");
 }
 
-void Game::create_enemy() {
-	//create enemy entity
-	unsigned long long enemy_id = em.new_entity();
-	em.assign_component<components::position>(enemy_id);
-	em.assign_component<components::render>(enemy_id);
-	em.assign_component<components::movement>(enemy_id);
-	em.assign_component<components::gravity>(enemy_id);
-	em.assign_component<components::collision>(enemy_id);
-	em.assign_component<components::damage>(enemy_id);
-
-	auto* enemy_position = em.get_component<components::position>(enemy_id);
-	enemy_position->pos.x = 500;
-	enemy_position->pos.y = 10;
-
-	auto* enemy_movement = em.get_component<components::movement>(enemy_id);
-	enemy_movement->speed = { 0.0,0.0 };
-	enemy_movement->acceleration = { 5.0f,5.0f };
-
-	enemy_movement->max_speed = { 100.0,100.0 };
-	enemy_movement->max_acceleration = { 5.0,5.0 };
-
-	auto* enemy_render = em.get_component<components::render>(enemy_id);
-	enemy_render->sprite_rect = { static_cast<float>(enemy_position->pos.x), static_cast<float>(enemy_position->pos.y), 30, 30 };
-
-	auto* enemy_collision = em.get_component<components::collision>(enemy_id);
-	enemy_collision->hitbox.x = enemy_position->pos.x;
-	enemy_collision->hitbox.y = enemy_position->pos.y;
-	enemy_collision->hitbox.w = enemy_render->sprite_rect.w;
-	enemy_collision->hitbox.h = enemy_render->sprite_rect.h;
-	enemy_collision->is_rigid = false;
-
-	auto* enemy_damage = em.get_component<components::damage>(enemy_id);
-	enemy_damage->damage_amount = 5;
+void Game::update_assets() {
+	assets.update(renderer, ASSET_UPLOAD_BUDGET);
+	if (sprites_applied || !assets.idle()) return;
+	sprites_applied = true;
+
+	//images that failed to load leave their entities as colored rects
+	types::atlas_region player_region = assets.region(player_sprite);
+	types::atlas_region enemy_region = assets.region(enemy_sprite);
+
+	for (auto [id, render, key_binds] : simulation.em.view<components::render, components::input>()) {
+		if (player_region.page < 0) break;
+		render.sprite = player_region;
+		render.render_color = { 0xFF,0xFF,0xFF,0xFF };
+	}
+
+	for (auto [id, render, damage, movement] : simulation.em.view<components::render, components::damage, components::movement>()) {
+		if (enemy_region.page < 0) break;
+		render.sprite = enemy_region;
+		render.render_color = { 0xFF,0xFF,0xFF,0xFF };
+	}
 }
 
 void Game::cleanup() {
+	//loaders may be in the middle of an SDL call and the atlas pages belong to the renderer, both go first
+	assets.stop();
+	render_system.get_atlas().release();
+
 	SDL_DestroyRenderer(renderer);
 	renderer = nullptr;
 
@@ -162,80 +89,133 @@ void Game::cleanup() {
 }
 
 void Game::run() {
-	double delta_time = 0.0;
-	unsigned int last_time = 0;
-	unsigned int current_time = SDL_GetPerformanceCounter();
+	const double step = 1.0 / SIMULATION_RATE;
+	const Uint64 frequency = SDL_GetPerformanceFrequency();
+	const Uint64 frame_ticks = static_cast<Uint64>(frequency / frame_rate);
+
+	double accumulator = 0.0;
+	Uint64 last_time = SDL_GetPerformanceCounter();
 
 	while (is_running) {
-		last_time = current_time;
-		current_time = SDL_GetPerformanceCounter();
+		Uint64 frame_start = SDL_GetPerformanceCounter();
+		accumulator += static_cast<double>(frame_start - last_time) / frequency;
+		last_time = frame_start;
 
-		delta_time = (double)(current_time - last_time) / SDL_GetPerformanceFrequency();
-		
 		handle_input();
 
-		if(!paused) 
-			update(delta_time);
+		if (paused) {
+			accumulator = 0.0;
+		}
+
+		//run as many fixed steps as the elapsed time allows, capped so a slow frame can't snowball
+		int steps = 0;
+		while (accumulator >= step && steps < MAX_STEPS_PER_FRAME) {
+			update(step);
+			accumulator -= step;
+			++steps;
+		}
+
+		if (accumulator >= step) {
+			accumulator = std::fmod(accumulator, step);
+		}
+
+		update_assets();
 
-		render();
+		//how far the current time is between the last two simulation steps
+		render(accumulator / step);
+
+		if (Profiler::enabled()) {
+			Profiler::get().end_frame();
+		}
 
-		SDL_Delay(16); //60 fps
+		Uint64 elapsed = SDL_GetPerformanceCounter() - frame_start;
+		if (elapsed < frame_ticks) {
+			SDL_DelayPrecise((frame_ticks - elapsed) * 1000000000ull / frequency);
+		}
 	}
 }
 
 void Game::handle_input() {
-	input.check_input();
+	simulation.input.check_input();
 
-	if (input.should_quit()) {
+	if (simulation.input.should_quit()) {
 		is_running = false;
 	}
 
 }
 
 void Game::update(double delta_time) {
-	movement_system.update(delta_time);
-
-	for (auto& e : em.entities) {
-		for (auto& other_entity : em.entities) {
-			if (e.id == other_entity.id) {
-				continue;
-			}
-			if (other_entity.mask.test(components::get_id<components::collision>())) {	
-				collision.detect_collision(e,other_entity);
-			}
-		}
+	simulation.step(delta_time);
+
+	//chunks streamed in or out changed the level geometry, and entities streamed out before the
+	//sprites were ready come back without them
+	if (simulation.streamer.generation() != streamed_generation) {
+		render_system.build_static_index();
+		streamed_generation = simulation.streamer.generation();
+		sprites_applied = false;
 	}
-
-	health_system.update(delta_time);
 }
 
-void Game::render() {
-	SDL_SetRenderDrawColor(renderer, 0x00, 0x00, 0x00, 0xFF);
-	SDL_RenderClear(renderer);
+void Game::render(double alpha) {
+	{
+		PROFILE_SCOPE("render");
+		SDL_SetRenderDrawColor(renderer, 0x00, 0x00, 0x00, 0xFF);
+		SDL_RenderClear(renderer);
 
-	for (auto& e : em.entities) {
-		if (e.mask.test(components::get_id<components::render>())) {
-			auto* entity_sprite = em.get_component<components::render>(e.id);
-			auto* entity_position = em.get_component<components::position>(e.id);
-			SDL_Color render_color = entity_sprite->render_color;
+		render_system.render(renderer, alpha);
+	}
 
-			entity_sprite->sprite_rect.x = entity_position->pos.x;
-			entity_sprite->sprite_rect.y = entity_position->pos.y;
+	if (profiler_overlay) {
+		draw_profiler_overlay();
+	}
+	SDL_RenderPresent(renderer);
 
-			SDL_SetRenderDrawColor(renderer, render_color.r, render_color.b, render_color.g, render_color.a);
-			SDL_RenderFillRect(renderer, &entity_sprite->sprite_rect);
+	if (!first_frame_shown) {
+		first_frame_shown = true;
+		double milliseconds = static_cast<double>(SDL_GetPerformanceCounter() - start_time) * 1000.0 / SDL_GetPerformanceFrequency();
+		LOG_INFO("First frame after {} ms", milliseconds);
+	}
 
-			if (e.mask.test(components::get_id < components::health>())) {
-				auto* entity_health = em.get_component<components::health>(e.id);
-				
-				SDL_FRect health_bar{ static_cast<float>(entity_position->pos.x), static_cast<float>(entity_position->pos.y - 30), entity_health->current_health, 10 };
+	report_render_stats();
+}
 
-				//draw red health bar of entity on top of it
-				SDL_SetRenderDrawColor(renderer, 0xFF, 0x00, 0x00, 0xFF);
-				SDL_RenderFillRect(renderer, &health_bar);
-			}
-		}
+void Game::report_render_stats() {
+	//once a second in the window title, so it doesn't cost a draw call itself
+	Uint64 now = SDL_GetPerformanceCounter();
+	if (now - last_report < SDL_GetPerformanceFrequency()) return;
+	last_report = now;
+
+	const render_stats& stats = render_system.last_render_stats();
+	const culling_stats& culling = render_system.last_culling_stats();
+	const streaming_stats& streaming = simulation.streamer.stats();
+	std::string title = "game | " + std::to_string(stats.draw_calls) + " draw calls, " + std::to_string(stats.rects) + " rects, " +
+		std::to_string(culling.drawn) + " drawn, " + std::to_string(culling.culled) + " culled, " + std::to_string(culling.tiles) + " tiles | chunks " +
+		std::to_string(streaming.active_chunks) + " active, " + std::to_string(streaming.loaded_chunks) + " loaded, " +
+		std::to_string(streaming.unloaded_chunks) + " on disk, " + std::to_string(static_cast<int>(streaming.max_activation_ms * 1000.0)) + " us worst activation";
+	SDL_SetWindowTitle(window, title.c_str());
+}
+void Game::draw_profiler_overlay() {
+	//SDL's debug font is 8x8, one line per marker over a translucent panel
+	const float line_height = 10.0f;
+	std::vector<profile_stats> stats = Profiler::get().stats();
+
+	SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+	SDL_SetRenderDrawColor(renderer, 0x00, 0x00, 0x00, 0xC0);
+	SDL_FRect panel{ 4.0f, 4.0f, 62.0f * 8.0f, (stats.size() + 2) * line_height + 4.0f };
+	SDL_RenderFillRect(renderer, &panel);
+
+	char line[128];
+	SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xFF);
+	std::snprintf(line, sizeof(line), "%-22s %8s %8s %8s %8s", "ms per frame", "last", "min", "avg", "p99");
+	SDL_RenderDebugText(renderer, 8.0f, 8.0f, line);
+
+	float y = 8.0f + line_height;
+	for (auto& marker : stats) {
+		std::snprintf(line, sizeof(line), "%-22.22s %8.3f %8.3f %8.3f %8.3f", marker.name.c_str(), marker.last_ms, marker.min_ms, marker.avg_ms, marker.p99_ms);
+		SDL_RenderDebugText(renderer, 8.0f, y, line);
+		y += line_height;
 	}
 
-	SDL_RenderPresent(renderer);
-}
\ No newline at end of file
+	std::snprintf(line, sizeof(line), "frame %llu, %zu events dropped", Profiler::get().frame(), Profiler::get().dropped_events());
+	SDL_RenderDebugText(renderer, 8.0f, y, line);
+}
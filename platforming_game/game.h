@@ -1,13 +1,21 @@
 #pragma once
 #include <SDL3/SDL.h>
-#include <iostream>
-#include "health_system.h"
-#include "movement.h"
-#include "input.h"
+#include <cstdio>
+#include <string>
+#include "asset_manager.h"
+#include "logger.h"
+#include "profiler.h"
+#include "render_system.h"
+#include "simulation.h"
+
+#define MAX_STEPS_PER_FRAME 8 //steps run at most per frame, time left over past that is dropped
+#define DEFAULT_FRAME_RATE 60 //frame rate cap when the display doesn't report its refresh rate
+#define ASSET_UPLOAD_BUDGET 0.002 //seconds of texture uploads allowed per frame
+#define PROFILER_OVERLAY_KEY SDL_SCANCODE_F3 //shows the profiler overlay and records while it's shown
 
 class Game {
 public:
-	Game();
+	Game(simulation_settings settings = simulation_settings(), std::string level_path = "levels/level1.txt");
 	~Game() {
 		cleanup();
 	}
@@ -19,22 +27,30 @@ private:
 	void cleanup();
 	void handle_input();
 	void update(double);
-	void render();
-
-	void create_player();
-	void create_enemy();
+	void render(double);
+	void report_render_stats();
+	void draw_profiler_overlay();
+	void request_sprites();
+	void update_assets();
 
 	bool is_running;
 	bool paused;
+	double frame_rate; //frames are paced to this rate, the simulation rate doesn't depend on it
+	Uint64 start_time; //performance counter when the game was created, for the time to first frame
+	std::string level_path; //the built-in level is used if it can't be loaded
 
 	SDL_Window* window;
 	SDL_Renderer* renderer;
-
-	entity_manager em;
-	Input_Handler input;
-
-	Movement_System movement_system;
-	Collision_System collision;
-	Health_System health_system;
-	//Render_System render_system;
+	Uint64 last_report = 0; //performance counter value of the last render stats report
+
+	Simulation simulation;
+	Render_System render_system;
+	Asset_Manager assets;
+
+	asset_handle player_sprite = 0;
+	asset_handle enemy_sprite = 0;
+	bool sprites_applied = false;
+	unsigned long long streamed_generation = 0; //streamer generation the static render index was built for
+	bool first_frame_shown = false;
+	bool profiler_overlay = false;
 };
\ No newline at end of file
@@ -1,76 +1,202 @@
 #include "health_system.h"
 
-Health_System::Health_System(entity_manager& em) : em(em) {}
-
-void Health_System::update(double delta_time) {
-	for (auto& e : em.entities) {
-		if (e.mask.test(components::get_id<components::health>())) {
-
-			if (e.mask.test(components::get_id<components::invincibility>())) {
-				auto* invincibility = em.get_component<components::invincibility>(e.id);
-				std::cout << "Invincibility remaining time: " << invincibility->remaining_time << "\n";
-				if (invincibility->remaining_time > 0.0) {
-					invincibility->remaining_time -= delta_time;
-				}
-				else {
-					// Remove the invincibility component when I-frames expire
-					em.remove_component<components::invincibility>(e.id);
-				}
-			}
+#define HEALTH_GRAIN 256 //entities updated per parallel job
 
-			if (e.mask.test(components::get_id<components::pending_damage>())) {
-				damage_entity(e.id, em.get_component<components::pending_damage>(e.id)->pending_amount);
-				em.remove_component<components::pending_damage>(e.id);
-			}
+Health_System::Health_System(entity_manager& em, Thread_Pool* pool) : em(em), pool(pool),
+	damage_events(em.events<damage_event>()), heal_events(em.events<heal_event>()), iframe_starts(pool ? pool->size() : 1) {
+
+	em.set_component_hooks<components::regeneration>(&start_regeneration, &stop_regeneration, this);
+	em.set_component_hooks<components::thorns>(&start_thorns, &stop_thorns, this);
+	em.set_component_hooks<components::health>(&restore_iframes, &stop_iframes, this);
+}
+
+Health_System::~Health_System() {
+	em.set_component_hooks<components::regeneration>(nullptr, nullptr, nullptr);
+	em.set_component_hooks<components::thorns>(nullptr, nullptr, nullptr);
+	em.set_component_hooks<components::health>(nullptr, nullptr, nullptr);
+}
+
+system_access Health_System::access() {
+	system_access access;
+	access.writes = component_mask<components::health>();
+	return access;
+}
+
+void Health_System::gather_events() {
+	if (incoming.size() < em.entities.size()) {
+		incoming.resize(em.entities.size());
+	}
+
+	//events for entities that died since they were sent, or never had health, are dropped
+	targets.clear();
+	for (auto& event : damage_events.read()) {
+		if (!em.has_component<components::health>(event.target)) continue;
+
+		incoming_events& events = incoming[event.target.index];
+		if (!events.damaged && !events.healed) targets.push_back(event.target);
+		events.damage += event.amount;
+		events.damaged = true;
+	}
+
+	for (auto& event : heal_events.read()) {
+		if (!em.has_component<components::health>(event.target)) continue;
 
-			//apply regeneration effect
-			if (e.mask.test(components::get_id<components::regeneration>())) {
-				heal_entity(e.id, em.get_component<components::regeneration>(e.id)->regen_amount);
+		incoming_events& events = incoming[event.target.index];
+		if (!events.damaged && !events.healed) targets.push_back(event.target);
+		events.heal += event.amount;
+		events.healed = true;
+	}
+}
+
+void Health_System::update(double) {
+	gather_events();
+
+	//targets only touch their own health and incoming entry and record their structural changes, so ranges can run on any thread
+	auto update_range = [&](size_t begin, size_t end) {
+		command_buffer& commands = em.deferred();
+
+		for (size_t i = begin; i < end; ++i) {
+			entity_handle id = targets[i];
+			components::health& health = *em.get_component<components::health>(id);
+			commands.set_sort_key(id.index);
+
+			health_state state{ id, &health, health.invincible, false };
+			incoming_events& events = incoming[id.index];
+
+			//damage first, a hit that kills can't be healed in the same step
+			if (events.damaged) {
+				damage_entity(state, events.damage);
 			}
 
-			//apply thorns effect
-			if (e.mask.test(components::get_id<components::thorns>())) {
-				damage_entity(e.id, em.get_component<components::thorns>(e.id)->damage);
+			if (events.healed && !state.dead) {
+				heal_entity(state, events.heal);
 			}
+
+			events = incoming_events();
 		}
-	}
+	};
+
+	if (pool) pool->parallel_for(0, targets.size(), HEALTH_GRAIN, update_range);
+	else update_range(0, targets.size());
+
+	start_iframes();
 }
 
-void Health_System::damage_entity(unsigned long long id, int amount) {
+void Health_System::damage_entity(health_state& state, int amount) {
+
+	if (state.invincible) {
+		return;
+	}
+
+	state.health->current_health -= amount;
 
-	if (em.entities[id].mask.test(components::get_id<components::invincibility>())) {
+	if (state.health->current_health <= 0) {
+		em.deferred().delete_entity(state.id);
+		state.dead = true;
 		return;
 	}
 
-	auto* entity_health = em.get_component<components::health>(id);
+	activate_iframes(state);
+}
+
+void Health_System::heal_entity(health_state& state, int amount) {
+	state.health->current_health += amount;
+
+	if (state.health->current_health > state.health->max_health) {
+		state.health->current_health = state.health->max_health;
+	}
+}
+
+void Health_System::activate_iframes(health_state& state) {
+	state.invincible = true;
+	if (state.health->i_frames <= 0) return;
 
-	entity_health->current_health -= amount;
+	//the timer wheel isn't thread safe, the timers are scheduled once the parallel pass is done
+	state.health->invincible = true;
+	iframe_starts[current_worker_index()].push_back(state.id);
+}
+
+void Health_System::start_iframes() {
+	//sorted so the timers are scheduled in the same order whatever thread hit which entity
+	std::vector<entity_handle>& started = iframe_starts[0];
+	for (size_t worker = 1; worker < iframe_starts.size(); ++worker) {
+		started.insert(started.end(), iframe_starts[worker].begin(), iframe_starts[worker].end());
+		iframe_starts[worker].clear();
+	}
+	std::sort(started.begin(), started.end());
 
-	if (entity_health->current_health <= 0) {
-		em.delete_entity(id);
+	for (entity_handle id : started) {
+		auto* health = em.get_component<components::health>(id);
+		health->iframes_timer = em.timers.schedule(static_cast<double>(health->i_frames) / 60.0, &end_iframes, this, id);
 	}
+	started.clear();
+}
+
+//assign_component runs the hook before the caller sets the interval, so the periodic timer is
+//started one tick later by a one-shot one, with the interval the component has by then
+void Health_System::start_regeneration(void* context, entity_manager& em, entity_handle id) {
+	em.get_component<components::regeneration>(id)->timer = em.timers.schedule(0.0, &arm_regeneration, context, id);
+}
+
+void Health_System::stop_regeneration(void*, entity_manager& em, entity_handle id) {
+	em.timers.cancel(em.get_component<components::regeneration>(id)->timer);
+}
+
+void Health_System::start_thorns(void* context, entity_manager& em, entity_handle id) {
+	em.get_component<components::thorns>(id)->timer = em.timers.schedule(0.0, &arm_thorns, context, id);
+}
 
-	if (entity_health->current_health > 0) {
-		activate_iframes(id, entity_health->i_frames);
+void Health_System::stop_thorns(void*, entity_manager& em, entity_handle id) {
+	em.timers.cancel(em.get_component<components::thorns>(id)->timer);
+}
+
+void Health_System::restore_iframes(void* context, entity_manager& em, entity_handle id) {
+	//an entity loaded or streamed back in while invincible lost its timer, it gets all of its i-frames again
+	auto* health = em.get_component<components::health>(id);
+	health->iframes_timer = timer_handle();
+	if (health->invincible) {
+		health->iframes_timer = em.timers.schedule(static_cast<double>(health->i_frames) / 60.0, &end_iframes, context, id);
 	}
 }
 
-void Health_System::heal_entity(unsigned long long id, int amount) {
-	auto* entity_health = em.get_component<components::health>(id);
+void Health_System::stop_iframes(void*, entity_manager& em, entity_handle id) {
+	em.timers.cancel(em.get_component<components::health>(id)->iframes_timer);
+}
+
+void Health_System::arm_regeneration(void* context, entity_handle id) {
+	Health_System& system = *static_cast<Health_System*>(context);
+	if (auto* regeneration = system.em.get_component<components::regeneration>(id)) {
+		double interval = std::max(regeneration->interval, TIMER_TICK_SECONDS);
+		regeneration->timer = system.em.timers.schedule(interval, &regenerate, context, id, interval);
+	}
+}
 
-	entity_health->current_health += amount;
+void Health_System::arm_thorns(void* context, entity_handle id) {
+	Health_System& system = *static_cast<Health_System*>(context);
+	if (auto* thorns = system.em.get_component<components::thorns>(id)) {
+		double interval = std::max(thorns->interval, TIMER_TICK_SECONDS);
+		thorns->timer = system.em.timers.schedule(interval, &prick, context, id, interval);
+	}
+}
 
-	if (entity_health->current_health > entity_health->max_health) {
-		entity_health->current_health = entity_health->max_health;
+void Health_System::regenerate(void* context, entity_handle id) {
+	Health_System& system = *static_cast<Health_System*>(context);
+	if (auto* regeneration = system.em.get_component<components::regeneration>(id)) {
+		system.heal_events.send(heal_event{ id, id, regeneration->regen_amount });
 	}
 }
 
-void Health_System::activate_iframes(unsigned long long id, int i_frames) {
-	if (!em.entities[id].mask.test(components::get_id<components::invincibility>())) {
-		em.assign_component<components::invincibility>(id);
+void Health_System::prick(void* context, entity_handle id) {
+	Health_System& system = *static_cast<Health_System*>(context);
+	if (auto* thorns = system.em.get_component<components::thorns>(id)) {
+		system.damage_events.send(damage_event{ id, id, thorns->damage });
 	}
+}
 
-	auto* invincibility_component = em.get_component<components::invincibility>(id);
-	invincibility_component->max_duration = static_cast<double>(i_frames) / 60.0;
-	invincibility_component->remaining_time = invincibility_component->max_duration;
-}
\ No newline at end of file
+void Health_System::end_iframes(void* context, entity_handle id) {
+	Health_System& system = *static_cast<Health_System*>(context);
+	if (auto* health = system.em.get_component<components::health>(id)) {
+		health->invincible = false;
+		health->iframes_timer = timer_handle();
+	}
+}
@@ -1,17 +1,70 @@
 #pragma once
+#include <vector>
 #include "entity.h"
+#include "job_system.h"
 
 class Health_System {
 public:
-	Health_System(entity_manager&);
+	//entities are updated in parallel ranges when a thread pool is given. sets the component hooks
+	//that start and stop the regeneration, thorns and i-frames timers in em.timers
+	Health_System(entity_manager&, Thread_Pool* pool = nullptr);
+	~Health_System();
 
-	//updates health components of each entity with one
+	Health_System(const Health_System&) = delete;
+	Health_System& operator=(const Health_System&) = delete;
+
+	//deaths are recorded through em.deferred() and applied after the stage, hits and i-frames
+	//don't add or remove any component
+	static system_access access();
+
+	//applies the damage and heal events sent during the last step, summed per entity. only the entities
+	//they target are visited: regeneration and thorns send their events from periodic timers and
+	//i-frames end with a one-shot timer, nothing is ticked per entity
 	void update(double);
 
 private:
-	void activate_iframes(unsigned long long, int);
-	void damage_entity(unsigned long long, int); //reduce health of entity by an amount
-	void heal_entity(unsigned long long, int); //heal entity by an amount
+	//what the current update knows about an entity, its recorded commands aren't visible until playback
+	struct health_state {
+		entity_handle id;
+		components::health* health;
+		bool invincible;
+		bool dead;
+	};
+
+	//events of one entity this update
+	struct incoming_events {
+		int damage = 0;
+		int heal = 0;
+		bool damaged = false;
+		bool healed = false;
+	};
+
+	void gather_events();
+	void start_iframes();
+	void activate_iframes(health_state&);
+	void damage_entity(health_state&, int); //reduce health of entity by an amount
+	void heal_entity(health_state&, int); //heal entity by an amount
+
+	//component hooks, the context is the Health_System
+	static void start_regeneration(void* context, entity_manager& em, entity_handle id);
+	static void stop_regeneration(void* context, entity_manager& em, entity_handle id);
+	static void start_thorns(void* context, entity_manager& em, entity_handle id);
+	static void stop_thorns(void* context, entity_manager& em, entity_handle id);
+	static void restore_iframes(void* context, entity_manager& em, entity_handle id);
+	static void stop_iframes(void* context, entity_manager& em, entity_handle id);
+
+	//timer callbacks
+	static void arm_regeneration(void* context, entity_handle id);
+	static void arm_thorns(void* context, entity_handle id);
+	static void regenerate(void* context, entity_handle id);
+	static void prick(void* context, entity_handle id);
+	static void end_iframes(void* context, entity_handle id);
 
 	entity_manager& em;
-};
\ No newline at end of file
+	Thread_Pool* pool;
+	event_queue<damage_event>& damage_events;
+	event_queue<heal_event>& heal_events;
+	std::vector<incoming_events> incoming; //indexed by entity slot, every entry is reset once it is applied
+	std::vector<entity_handle> targets; //entities with events this update, once each
+	std::vector<std::vector<entity_handle>> iframe_starts; //per pool worker, their timers are scheduled after the parallel pass
+};
@@ -1,7 +1,9 @@
 #pragma once
 #include <SDL3/SDL.h>
 #include <functional>
+#include <algorithm>
 #include <array>
+#include <vector>
 #include "entity.h"
 
 struct key {
@@ -27,11 +29,9 @@ public:
 		return is_key_pressed(SDL_SCANCODE_P);
 	}
 
+	//released flags stay set until clear_released, so a release is seen by the next simulation step
+	//even when a frame runs no step at all
 	void check_input() {
-		for (auto& k : keys) {
-			k.released = false;
-		}
-
 		while (SDL_PollEvent(&keyboard_event)) {
 
 			if (keyboard_event.type == SDL_EVENT_QUIT) {
@@ -39,35 +39,53 @@ public:
 			}
 
 			if (keyboard_event.type == SDL_EVENT_KEY_DOWN) {
-				unsigned int key_code = keyboard_event.key.scancode;
-
-				if (!keys[key_code].pressed) {
-					//if the key was not pressed, set it's state as pressed
-					keys[key_code].pressed = true;
-					keys[key_code].pressed_time = static_cast<double>(SDL_GetTicks());
-				}
-
-				//if the key as an assigned action, execute it when the key is pressed
-				if (keys[key_code].action) {
-					keys[key_code].action();
-				}
+				press_key(keyboard_event.key.scancode);
 			}
 			
 			if (keyboard_event.type == SDL_EVENT_KEY_UP) {
-				//set key state as not pressed and compute total pressed time
-				unsigned int key_code = keyboard_event.key.scancode;
+				release_key(keyboard_event.key.scancode);
+			}
+		}
+	}
 
-				keys[key_code].pressed = false;
-				keys[key_code].released = true;
-				keys[key_code].last_duration = SDL_GetTicks() - keys[key_code].pressed_time;
+	void press_key(unsigned int key_code) {
+		if (!keys[key_code].pressed) {
+			//if the key was not pressed, set it's state as pressed
+			keys[key_code].pressed = true;
+			keys[key_code].pressed_time = now();
+		}
 
-			}
+		//if the key as an assigned action, execute it when the key is pressed
+		if (keys[key_code].action) {
+			keys[key_code].action();
 		}
 	}
 
+	void release_key(unsigned int key_code) {
+		//set key state as not pressed and compute total pressed time
+		keys[key_code].pressed = false;
+		keys[key_code].released = true;
+		keys[key_code].last_duration = now() - keys[key_code].pressed_time;
+	}
+
+	//milliseconds used for key press durations, SDL_GetTicks unless the clock was made manual
+	double now() const {
+		return manual_clock ? manual_time : static_cast<double>(SDL_GetTicks());
+	}
+
+	//stops following SDL_GetTicks, time only moves through advance_time. used by scripted input
+	void use_manual_clock(double start_time = 0.0) {
+		manual_clock = true;
+		manual_time = start_time;
+	}
+
+	void advance_time(double milliseconds) {
+		manual_time += milliseconds;
+	}
+
 	double key_time(unsigned int scancode) {
 		if (is_key_pressed(scancode)) {
-			return SDL_GetTicks() - keys[scancode].pressed_time ;
+			return now() - keys[scancode].pressed_time;
 		}
 
 		return 0.0;
@@ -77,6 +95,13 @@ public:
 		return keys[scancode].last_duration;
 	}
 
+	//called once a simulation step has seen the released keys
+	void clear_released() {
+		for (auto& k : keys) {
+			k.released = false;
+		}
+	}
+
 	void assign_action(unsigned int scancode, std::function<void()> action) {
 		if (!keys[scancode].action) {
 			keys[scancode].action = action;
@@ -96,4 +121,49 @@ private:
 	SDL_Event keyboard_event;
 	std::array<key, 256> keys;
 	bool quit;
+	bool manual_clock = false;
+	double manual_time = 0.0;
+};
+
+//key presses and releases fed to an Input_Handler at given simulation ticks, replaces the keyboard
+//when there is no window (headless runs, benchmarks)
+class Input_Script {
+public:
+	void press(unsigned long long tick, unsigned int scancode) {
+		add(tick, scancode, true);
+	}
+
+	void release(unsigned long long tick, unsigned int scancode) {
+		add(tick, scancode, false);
+	}
+
+	//applies every event of `tick`, ticks have to be applied in increasing order
+	void apply(unsigned long long tick, Input_Handler& input) {
+		while (next < events.size() && events[next].tick <= tick) {
+			if (events[next].pressed) input.press_key(events[next].scancode);
+			else input.release_key(events[next].scancode);
+			++next;
+		}
+	}
+
+	bool empty() const {
+		return events.empty();
+	}
+
+private:
+	struct scripted_key {
+		unsigned long long tick;
+		unsigned int scancode;
+		bool pressed;
+	};
+
+	void add(unsigned long long tick, unsigned int scancode, bool pressed) {
+		//kept sorted by tick, events of the same tick stay in the order they were added
+		auto position = std::upper_bound(events.begin(), events.end(), tick,
+			[](unsigned long long value, const scripted_key& event) { return value < event.tick; });
+		events.insert(position, scripted_key{ tick, scancode, pressed });
+	}
+
+	std::vector<scripted_key> events;
+	size_t next = 0;
 };
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include "integration.h"
+#include <algorithm>
+
+namespace {
+    void integrate_scalar(body_batch& batch, size_t begin, double delta_time, double scale) {
+        for (size_t i = begin; i < batch.count; ++i) {
+            double speed_y = batch.speed_y[i] + batch.gravity[i] * delta_time;
+            speed_y = std::min(std::max(speed_y, -batch.max_speed_y[i]), batch.max_speed_y[i]);
+
+            batch.speed_y[i] = speed_y;
+            batch.x[i] += batch.speed_x[i] * scale;
+            batch.y[i] += speed_y * scale;
+        }
+    }
+
+#if SIMD_X86
+    //the min/max operand order matches std::min(std::max(...)) so NaNs come out the same way
+    size_t integrate_sse(body_batch& batch, double delta_time, double scale) {
+        __m128d step = _mm_set1_pd(delta_time);
+        __m128d factor = _mm_set1_pd(scale);
+        __m128d sign = _mm_set1_pd(-0.0);
+
+        size_t i = 0;
+        for (; i + 2 <= batch.count; i += 2) {
+            __m128d max_speed = _mm_load_pd(&batch.max_speed_y[i]);
+            __m128d speed_y = _mm_add_pd(_mm_load_pd(&batch.speed_y[i]), _mm_mul_pd(_mm_load_pd(&batch.gravity[i]), step));
+            speed_y = _mm_min_pd(max_speed, _mm_max_pd(_mm_xor_pd(max_speed, sign), speed_y));
+
+            _mm_store_pd(&batch.speed_y[i], speed_y);
+            _mm_store_pd(&batch.x[i], _mm_add_pd(_mm_load_pd(&batch.x[i]), _mm_mul_pd(_mm_load_pd(&batch.speed_x[i]), factor)));
+            _mm_store_pd(&batch.y[i], _mm_add_pd(_mm_load_pd(&batch.y[i]), _mm_mul_pd(speed_y, factor)));
+        }
+        return i;
+    }
+
+    SIMD_AVX2_TARGET size_t integrate_avx2(body_batch& batch, double delta_time, double scale) {
+        __m256d step = _mm256_set1_pd(delta_time);
+        __m256d factor = _mm256_set1_pd(scale);
+        __m256d sign = _mm256_set1_pd(-0.0);
+
+        size_t i = 0;
+        for (; i + 4 <= batch.count; i += 4) {
+            __m256d max_speed = _mm256_load_pd(&batch.max_speed_y[i]);
+            __m256d speed_y = _mm256_add_pd(_mm256_load_pd(&batch.speed_y[i]), _mm256_mul_pd(_mm256_load_pd(&batch.gravity[i]), step));
+            speed_y = _mm256_min_pd(max_speed, _mm256_max_pd(_mm256_xor_pd(max_speed, sign), speed_y));
+
+            _mm256_store_pd(&batch.speed_y[i], speed_y);
+            _mm256_store_pd(&batch.x[i], _mm256_add_pd(_mm256_load_pd(&batch.x[i]), _mm256_mul_pd(_mm256_load_pd(&batch.speed_x[i]), factor)));
+            _mm256_store_pd(&batch.y[i], _mm256_add_pd(_mm256_load_pd(&batch.y[i]), _mm256_mul_pd(speed_y, factor)));
+        }
+        return i;
+    }
+#endif
+}
+
+void integrate_bodies(body_batch& batch, double delta_time, double scale, simd_isa isa) {
+    size_t done = 0;
+
+#if SIMD_X86
+    isa = supported_simd_isa(isa);
+
+    //the bodies left over past the last full vector go through the scalar version
+    if (isa == simd_isa::AVX2) done = integrate_avx2(batch, delta_time, scale);
+    else if (isa == simd_isa::SSE) done = integrate_sse(batch, delta_time, scale);
+#else
+    (void)isa;
+#endif
+
+    integrate_scalar(batch, done, delta_time, scale);
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstddef>
+#include "simd.h"
+
+#define BODY_BATCH_SIZE 128 //bodies per batch, small enough for a batch to stay in L1 between gather and write back
+
+//position, speed and gravity of bodies Movement_System integrates in bulk, as structure of arrays
+struct body_batch {
+    size_t count = 0;
+    alignas(32) double x[BODY_BATCH_SIZE];
+    alignas(32) double y[BODY_BATCH_SIZE];
+    alignas(32) double speed_x[BODY_BATCH_SIZE];
+    alignas(32) double speed_y[BODY_BATCH_SIZE];
+    alignas(32) double max_speed_y[BODY_BATCH_SIZE];
+    alignas(32) double gravity[BODY_BATCH_SIZE]; //falling strength, 0 for bodies without gravity
+};
+
+//integrates the bodies of the batch: gravity is added to the vertical speed, which is clamped to
+//max_speed_y, then the bodies move by their speed times `scale` (the step in speed time units).
+//every version gives exactly the same results, SSE does 2 bodies at a time and AVX2 4. the scalar loop
+//is the default, the SIMD versions don't beat it on a batch this memory bound
+void integrate_bodies(body_batch& batch, double delta_time, double scale, simd_isa isa = simd_isa::SCALAR);
@@ -0,0 +1,211 @@
+#include "job_system.h"
+#include <algorithm>
+
+namespace {
+    thread_local unsigned int worker_index = 0;
+    thread_local unsigned int system_index = 0;
+}
+
+unsigned int current_worker_index() {
+    return worker_index;
+}
+
+unsigned int current_system_index() {
+    return system_index;
+}
+
+Thread_Pool::Thread_Pool(unsigned int thread_count) {
+    if (thread_count == 0) thread_count = 1;
+
+    for (unsigned int i = 0; i < thread_count; ++i) {
+        queues.push_back(std::make_unique<job_queue>());
+    }
+
+    for (unsigned int i = 1; i < thread_count; ++i) {
+        threads.emplace_back(&Thread_Pool::worker_loop, this, i);
+    }
+}
+
+Thread_Pool::~Thread_Pool() {
+    {
+        std::lock_guard<std::mutex> guard(sleep_lock);
+        stopping = true;
+    }
+    wake_up.notify_all();
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+unsigned int Thread_Pool::current_worker() {
+    return current_worker_index();
+}
+
+void Thread_Pool::submit(const job& new_job) {
+    //spread the jobs over every queue so idle workers find them without stealing
+    unsigned int target = next_queue.fetch_add(1, std::memory_order_relaxed) % size();
+
+    {
+        std::lock_guard<std::mutex> guard(queues[target]->lock);
+        queues[target]->jobs.push_back(new_job);
+    }
+
+    queued.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> guard(sleep_lock);
+    }
+    wake_up.notify_one();
+}
+
+bool Thread_Pool::try_run_one(unsigned int worker) {
+    job next{};
+    bool found = false;
+
+    //own queue first (newest job, its data is likely still in cache), then steal the oldest job of the others
+    {
+        job_queue& own = *queues[worker];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.jobs.empty()) {
+            next = own.jobs.back();
+            own.jobs.pop_back();
+            found = true;
+        }
+    }
+
+    for (unsigned int i = 1; !found && i < size(); ++i) {
+        job_queue& victim = *queues[(worker + i) % size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.jobs.empty()) {
+            next = victim.jobs.front();
+            victim.jobs.pop_front();
+            found = true;
+        }
+    }
+
+    if (!found) return false;
+
+    queued.fetch_sub(1);
+
+    unsigned int previous_system = system_index;
+    system_index = next.system;
+    next.run(next.context, next.begin, next.end);
+    system_index = previous_system;
+
+    next.pending->fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+}
+
+void Thread_Pool::wait(std::atomic<size_t>& pending) {
+    unsigned int worker = current_worker();
+
+    //help with any job while ours are still running
+    while (pending.load(std::memory_order_acquire) > 0) {
+        if (!try_run_one(worker)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void Thread_Pool::worker_loop(unsigned int worker) {
+    worker_index = worker;
+
+    while (true) {
+        if (try_run_one(worker)) continue;
+
+        std::unique_lock<std::mutex> guard(sleep_lock);
+        wake_up.wait(guard, [this]() { return stopping || queued.load() > 0; });
+
+        if (stopping) return;
+    }
+}
+
+void Thread_Pool::run_all(std::vector<std::function<void()>*>& tasks) {
+    if (tasks.empty()) return;
+
+    if (size() == 1 || tasks.size() == 1) {
+        for (auto* task : tasks) {
+            (*task)();
+        }
+        return;
+    }
+
+    auto call = [](void* context, size_t, size_t) {
+        (*static_cast<std::function<void()>*>(context))();
+    };
+
+    std::atomic<size_t> pending(tasks.size());
+    for (auto* task : tasks) {
+        submit(job{ call, task, 0, 0, &pending, current_system_index() });
+    }
+
+    wait(pending);
+}
+
+System_Scheduler::System_Scheduler(Thread_Pool& pool, entity_manager& em) : pool(pool), em(em) {
+    em.set_worker_count(pool.size());
+}
+
+void System_Scheduler::add_system(const std::string& name, const system_access& access, std::function<void(double)> update) {
+    size_t index = systems.size();
+    systems.push_back(registered_system{ name, access, std::move(update), nullptr, 0.0, 0.0, Profiler::get().marker(name) });
+
+    //one stage after the last stage holding a conflicting system
+    size_t stage = 0;
+    for (size_t s = 0; s < stages.size(); ++s) {
+        for (size_t other : stages[s]) {
+            if (systems[other].access.conflicts_with(access)) {
+                stage = s + 1;
+            }
+        }
+    }
+
+    if (stage == stages.size()) {
+        stages.emplace_back();
+    }
+    stages[stage].push_back(index);
+
+    //tasks capture the system index, so they stay valid when the vector grows
+    for (size_t i = 0; i < systems.size(); ++i) {
+        systems[i].task = [this, i]() {
+            //commands recorded by the system are played back in registration order
+            system_index = static_cast<unsigned int>(i);
+            auto start = std::chrono::steady_clock::now();
+
+            {
+                PROFILE_MARKER_SCOPE(systems[i].marker);
+                systems[i].update(current_delta_time);
+            }
+
+            systems[i].last_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            systems[i].total_time += systems[i].last_time;
+            system_index = 0;
+        };
+    }
+}
+
+void System_Scheduler::run(double delta_time) {
+    current_delta_time = delta_time;
+
+    //timers fire first so the events they send are read during this run, together with the ones
+    //sent during the last run
+    {
+        PROFILE_SCOPE("timers");
+        em.timers.advance(delta_time);
+    }
+    em.swap_events();
+
+    for (auto& stage : stages) {
+        stage_tasks.clear();
+        for (size_t index : stage) {
+            stage_tasks.push_back(&systems[index].task);
+        }
+
+        //stages are the sync points: every system of a stage is done before the next one starts,
+        //and only then are the structural changes they recorded applied
+        pool.run_all(stage_tasks);
+
+        PROFILE_SCOPE("commands");
+        em.apply_commands();
+    }
+}
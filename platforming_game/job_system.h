@@ -0,0 +1,157 @@
+#pragma once
+#include <atomic>
+#include <bitset>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "entity.h"
+#include "profiler.h"
+
+//a unit of work: a range of a parallel loop or a whole system
+struct job {
+    void (*run)(void* context, size_t begin, size_t end);
+    void* context;
+    size_t begin;
+    size_t end;
+    std::atomic<size_t>* pending; //decremented once the job is done
+    unsigned int system; //scheduler system that submitted the job, commands recorded by the job belong to it
+};
+
+//work stealing thread pool. the thread that creates the pool is worker 0 and helps running jobs
+//while it waits for them, the other workers sleep while every queue is empty
+class Thread_Pool {
+public:
+    //thread_count includes the calling thread, 1 runs everything inline
+    explicit Thread_Pool(unsigned int thread_count = std::thread::hardware_concurrency());
+    ~Thread_Pool();
+
+    Thread_Pool(const Thread_Pool&) = delete;
+    Thread_Pool& operator=(const Thread_Pool&) = delete;
+
+    unsigned int size() const {
+        return static_cast<unsigned int>(queues.size());
+    }
+
+    //index of the worker running the calling code, 0 outside the pool threads
+    static unsigned int current_worker();
+
+    //splits [begin, end) into ranges of at most `grain` elements and calls fn(range_begin, range_end)
+    //on them in parallel, returns once every range is done. fn must not depend on which thread runs it
+    template<class Fn>
+    void parallel_for(size_t begin, size_t end, size_t grain, Fn&& fn) {
+        if (end <= begin) return;
+        if (grain == 0) grain = 1;
+
+        if (size() == 1 || end - begin <= grain) {
+            fn(begin, end);
+            return;
+        }
+
+        using function_type = std::remove_reference_t<Fn>;
+        auto call = [](void* context, size_t range_begin, size_t range_end) {
+            (*static_cast<function_type*>(context))(range_begin, range_end);
+        };
+
+        std::atomic<size_t> pending((end - begin + grain - 1) / grain);
+        for (size_t range = begin; range < end; range += grain) {
+            submit(job{ call, const_cast<void*>(static_cast<const void*>(&fn)), range, std::min(end, range + grain), &pending, current_system_index() });
+        }
+
+        wait(pending);
+    }
+
+    //runs every task in parallel and returns once all of them are done
+    void run_all(std::vector<std::function<void()>*>& tasks);
+
+private:
+    void submit(const job& new_job);
+    bool try_run_one(unsigned int worker);
+    void wait(std::atomic<size_t>& pending);
+    void worker_loop(unsigned int worker);
+
+    struct job_queue {
+        std::mutex lock;
+        std::deque<job> jobs;
+    };
+
+    std::vector<std::unique_ptr<job_queue>> queues; //one per worker, the owner pops from the back and thieves from the front
+    std::vector<std::thread> threads;
+    std::atomic<unsigned int> next_queue{ 0 };
+    std::atomic<int> queued{ 0 };
+    std::atomic<bool> stopping{ false };
+
+    std::mutex sleep_lock;
+    std::condition_variable wake_up;
+};
+
+//components a system reads and writes. `structural` systems create or delete entities or add and
+//remove components directly, so they can't share a stage with any other system. systems recording
+//those changes through em.deferred() instead don't need to be structural
+struct system_access {
+    std::bitset<MAX_COMPONENTS> reads;
+    std::bitset<MAX_COMPONENTS> writes;
+    bool structural = false;
+
+    bool conflicts_with(const system_access& other) const {
+        if (structural || other.structural) return true;
+        return (writes & (other.reads | other.writes)).any() || (other.writes & reads).any();
+    }
+};
+
+//runs the registered systems in stages: a system goes into the first stage after every earlier
+//system it conflicts with, systems sharing a stage run concurrently on the thread pool.
+//the stage layout only depends on the registration order, never on the number of threads
+class System_Scheduler {
+public:
+    System_Scheduler(Thread_Pool& pool, entity_manager& em);
+
+    void add_system(const std::string& name, const system_access& access, std::function<void(double)> update);
+    void run(double delta_time);
+
+    //system indices of each stage, in registration order
+    const std::vector<std::vector<size_t>>& get_stages() const {
+        return stages;
+    }
+
+    const std::string& system_name(size_t index) const {
+        return systems[index].name;
+    }
+
+    size_t system_count() const {
+        return systems.size();
+    }
+
+    //seconds spent in the update of a system during the last run and since it was added
+    double system_last_time(size_t index) const {
+        return systems[index].last_time;
+    }
+
+    double system_total_time(size_t index) const {
+        return systems[index].total_time;
+    }
+
+private:
+    struct registered_system {
+        std::string name;
+        system_access access;
+        std::function<void(double)> update;
+        std::function<void()> task; //update bound to the current delta time, for the thread pool
+        double last_time;
+        double total_time;
+        std::uint32_t marker; //profiler marker named after the system
+    };
+
+    Thread_Pool& pool;
+    entity_manager& em;
+    std::vector<registered_system> systems;
+    std::vector<std::vector<size_t>> stages;
+    std::vector<std::function<void()>*> stage_tasks;
+    double current_delta_time = 0.0;
+};
@@ -0,0 +1,653 @@
+#include "level.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include "logger.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    //read only view of a whole file
+    class mapped_file {
+    public:
+        ~mapped_file() {
+#ifdef _WIN32
+            if (data) UnmapViewOfFile(data);
+            if (mapping) CloseHandle(mapping);
+            if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+            if (data) munmap(const_cast<unsigned char*>(data), size);
+#endif
+        }
+
+        bool open(const std::string& path) {
+#ifdef _WIN32
+            file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE) return false;
+
+            LARGE_INTEGER file_size;
+            if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) return false;
+            size = static_cast<size_t>(file_size.QuadPart);
+
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!mapping) return false;
+
+            data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+            int descriptor = ::open(path.c_str(), O_RDONLY);
+            if (descriptor < 0) return false;
+
+            struct stat info;
+            if (fstat(descriptor, &info) != 0 || info.st_size == 0) {
+                close(descriptor);
+                return false;
+            }
+            size = static_cast<size_t>(info.st_size);
+
+            void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            close(descriptor); //the mapping stays valid
+            data = mapped == MAP_FAILED ? nullptr : static_cast<const unsigned char*>(mapped);
+#endif
+            return data != nullptr;
+        }
+
+        const unsigned char* data = nullptr;
+        size_t size = 0;
+
+    private:
+#ifdef _WIN32
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+#endif
+    };
+
+    component_value* find_component(std::vector<component_value>& components, const component_schema* schema) {
+        for (auto& value : components) {
+            if (value.schema == schema) return &value;
+        }
+        return nullptr;
+    }
+
+    component_value& get_or_add(std::vector<component_value>& components, const component_schema* schema) {
+        if (component_value* found = find_component(components, schema)) return *found;
+        components.push_back(component_value{ schema, schema->defaults });
+        return components.back();
+    }
+
+    //moves the position, sprite rect and hitbox of an entity placed at (x, y)
+    void offset_entity(std::vector<component_value>& components, double x, double y) {
+        if (component_value* value = find_component(components, find_schema("position"))) {
+            auto* position = reinterpret_cast<components::position*>(value->bytes.data());
+            position->pos.x += x;
+            position->pos.y += y;
+            position->previous_pos = position->pos;
+        }
+
+        if (component_value* value = find_component(components, find_schema("render"))) {
+            auto* render = reinterpret_cast<components::render*>(value->bytes.data());
+            render->sprite_rect.x += static_cast<float>(x);
+            render->sprite_rect.y += static_cast<float>(y);
+        }
+
+        if (component_value* value = find_component(components, find_schema("collision"))) {
+            auto* collision = reinterpret_cast<components::collision*>(value->bytes.data());
+            collision->hitbox.x += static_cast<float>(x);
+            collision->hitbox.y += static_cast<float>(y);
+        }
+    }
+
+    bool apply_assignment(component_value& value, const std::string& assignment, std::string& error) {
+        size_t equals = assignment.find('=');
+        if (equals == std::string::npos) {
+            error = "expected field=value, got " + assignment;
+            return false;
+        }
+
+        std::string field_name = assignment.substr(0, equals);
+        const component_field* field = value.schema->find_field(field_name);
+        if (!field) {
+            error = "component " + value.schema->name + " has no field " + field_name;
+            return false;
+        }
+
+        if (!parse_field(*field, assignment.substr(equals + 1), value.bytes.data())) {
+            error = "bad value for " + value.schema->name + "." + field_name + ": " + assignment.substr(equals + 1);
+            return false;
+        }
+        return true;
+    }
+
+    //'.' is empty, 0-9 and a-z are tile ids 0 to 35
+    bool tile_id(char cell, std::uint16_t& id) {
+        if (cell == '.') id = TILE_EMPTY;
+        else if (cell >= '0' && cell <= '9') id = static_cast<std::uint16_t>(cell - '0');
+        else if (cell >= 'a' && cell <= 'z') id = static_cast<std::uint16_t>(cell - 'a' + 10);
+        else return false;
+        return true;
+    }
+
+    //tile <id> [solid] [damage=N] [color=r,g,b,a]
+    bool parse_tile(std::istringstream& tokens, level_data& level, std::string& error) {
+        int id = 0;
+        if (!(tokens >> id) || id <= TILE_EMPTY || id > 35) {
+            error = "expected tile <id> with an id from 1 to 35";
+            return false;
+        }
+
+        tile_type type;
+        std::string option;
+        while (tokens >> option) {
+            int r, g, b, a;
+            if (option == "solid") type.solid = true;
+            else if (std::sscanf(option.c_str(), "damage=%d", &type.damage) == 1) continue;
+            else if (std::sscanf(option.c_str(), "color=%d,%d,%d,%d", &r, &g, &b, &a) == 4) {
+                type.color = { static_cast<Uint8>(r), static_cast<Uint8>(g), static_cast<Uint8>(b), static_cast<Uint8>(a) };
+            }
+            else {
+                error = "unknown tile option " + option;
+                return false;
+            }
+        }
+
+        level.tilemap.define_tile(static_cast<std::uint16_t>(id), type);
+        return true;
+    }
+
+    //rows can have different lengths, the map is as wide as the longest one
+    bool build_tilemap(const std::vector<std::string>& rows, Tilemap& tilemap, std::string& error) {
+        size_t width = 0;
+        for (auto& row : rows) {
+            width = std::max(width, row.size());
+        }
+
+        tilemap.width = static_cast<int>(width);
+        tilemap.height = static_cast<int>(rows.size());
+        tilemap.tiles.assign(width * rows.size(), TILE_EMPTY);
+
+        for (size_t row = 0; row < rows.size(); ++row) {
+            for (size_t column = 0; column < rows[row].size(); ++column) {
+                std::uint16_t id;
+                if (!tile_id(rows[row][column], id)) {
+                    error = std::string("bad tile '") + rows[row][column] + "'";
+                    return false;
+                }
+                tilemap.set(static_cast<int>(column), static_cast<int>(row), id);
+            }
+        }
+        return true;
+    }
+
+    size_t align_offset(size_t offset) {
+        return (offset + 15) & ~static_cast<size_t>(15);
+    }
+}
+
+bool parse_level(const std::string& text, level_data& level, std::string& error) {
+    std::istringstream lines(text);
+    std::string line;
+    int line_number = 0;
+    level_prefab* open_prefab = nullptr;
+    bool in_tilemap = false;
+    std::vector<std::string> tile_rows;
+
+    auto fail = [&](const std::string& message) {
+        error = "line " + std::to_string(line_number) + ": " + message;
+        return false;
+    };
+
+    while (std::getline(lines, line)) {
+        ++line_number;
+
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+
+        std::istringstream tokens(line);
+        std::string keyword;
+        if (!(tokens >> keyword)) continue;
+
+        if (in_tilemap) {
+            if (keyword == "end") {
+                in_tilemap = false;
+                if (!build_tilemap(tile_rows, level.tilemap, error)) return fail(error);
+            }
+            else {
+                tile_rows.push_back(keyword);
+            }
+        }
+        else if (open_prefab) {
+            if (keyword == "end") {
+                open_prefab = nullptr;
+                continue;
+            }
+
+            //component line: component [field=value ...]
+            const component_schema* schema = find_schema(keyword);
+            if (!schema) return fail("unknown component " + keyword);
+
+            component_value& value = get_or_add(open_prefab->components, schema);
+            std::string assignment;
+            while (tokens >> assignment) {
+                if (!apply_assignment(value, assignment, error)) return fail(error);
+            }
+        }
+        else if (keyword == "prefab") {
+            std::string name;
+            if (!(tokens >> name)) return fail("prefab without a name");
+
+            level.prefabs.push_back(level_prefab{ name, {} });
+            open_prefab = &level.prefabs.back();
+        }
+        else if (keyword == "tile") {
+            if (!parse_tile(tokens, level, error)) return fail(error);
+        }
+        else if (keyword == "tilemap") {
+            //tilemap tile_size x y, then the rows
+            if (!(tokens >> level.tilemap.tile_size >> level.tilemap.origin_x >> level.tilemap.origin_y) || level.tilemap.tile_size <= 0.0f) {
+                return fail("expected tilemap <tile size> <x> <y>");
+            }
+            if (!level.tilemap.empty()) return fail("only one tilemap per level");
+
+            in_tilemap = true;
+            tile_rows.clear();
+        }
+        else if (keyword == "entity") {
+            //entity prefab x y [component.field=value ...]
+            std::string prefab_name;
+            double x = 0.0;
+            double y = 0.0;
+            if (!(tokens >> prefab_name >> x >> y)) return fail("expected entity <prefab> <x> <y>");
+
+            const level_prefab* prefab = nullptr;
+            for (auto& candidate : level.prefabs) {
+                if (candidate.name == prefab_name) prefab = &candidate;
+            }
+            if (!prefab) return fail("unknown prefab " + prefab_name);
+
+            level.entities.push_back(prefab->components);
+            std::vector<component_value>& components = level.entities.back();
+
+            std::string assignment;
+            while (tokens >> assignment) {
+                size_t dot = assignment.find('.');
+                if (dot == std::string::npos) return fail("expected component.field=value, got " + assignment);
+
+                const component_schema* schema = find_schema(assignment.substr(0, dot));
+                if (!schema) return fail("unknown component " + assignment.substr(0, dot));
+
+                if (!apply_assignment(get_or_add(components, schema), assignment.substr(dot + 1), error)) return fail(error);
+            }
+
+            //overrides are relative to the prefab, like its own values
+            offset_entity(components, x, y);
+        }
+        else {
+            return fail("unknown keyword " + keyword);
+        }
+    }
+
+    if (open_prefab) {
+        error = "prefab " + open_prefab->name + " has no end";
+        return false;
+    }
+    if (in_tilemap) {
+        error = "tilemap has no end";
+        return false;
+    }
+    return true;
+}
+
+bool read_level_text(const std::string& path, level_data& level) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        LOG_ERROR("Could not open level {}", path);
+        return false;
+    }
+
+    std::stringstream contents;
+    contents << file.rdbuf();
+
+    std::string error;
+    if (!parse_level(contents.str(), level, error)) {
+        LOG_ERROR("Could not parse level {}, {}", path, error);
+        return false;
+    }
+    return true;
+}
+
+namespace {
+    struct cooked_column {
+        const component_schema* schema;
+        std::vector<std::uint32_t> entities;
+        std::vector<unsigned char> data;
+    };
+
+    void write_cooked(std::uint32_t entity_count, const std::vector<cooked_column>& columns, const Tilemap* tilemap, std::vector<unsigned char>& out) {
+        level_file_header header{};
+        std::memcpy(header.magic, "LVLB", 4);
+        header.version = LEVEL_FILE_VERSION;
+        header.entity_count = entity_count;
+        header.column_count = static_cast<std::uint32_t>(columns.size());
+
+        //header, column table, then the arrays, each 16 byte aligned
+        std::vector<level_column_header> table(columns.size());
+        size_t offset = align_offset(sizeof(header) + table.size() * sizeof(level_column_header));
+
+        for (size_t i = 0; i < columns.size(); ++i) {
+            level_column_header& entry = table[i];
+            std::memset(&entry, 0, sizeof(entry));
+            std::strncpy(entry.component, columns[i].schema->name.c_str(), LEVEL_COMPONENT_NAME_SIZE - 1);
+            entry.element_size = static_cast<std::uint32_t>(columns[i].schema->size);
+            entry.count = static_cast<std::uint32_t>(columns[i].entities.size());
+
+            entry.entities_offset = offset;
+            offset = align_offset(offset + columns[i].entities.size() * sizeof(std::uint32_t));
+            entry.data_offset = offset;
+            offset = align_offset(offset + columns[i].data.size());
+        }
+
+        level_tilemap_header tiles_header{};
+        if (tilemap && !tilemap->empty()) {
+            tiles_header.width = tilemap->width;
+            tiles_header.height = tilemap->height;
+            tiles_header.tile_size = tilemap->tile_size;
+            tiles_header.origin_x = tilemap->origin_x;
+            tiles_header.origin_y = tilemap->origin_y;
+            tiles_header.type_count = static_cast<std::uint32_t>(tilemap->types.size());
+
+            header.tilemap_offset = offset;
+            offset = align_offset(offset + sizeof(tiles_header) + tilemap->types.size() * sizeof(tile_type) +
+                tilemap->tiles.size() * sizeof(std::uint16_t));
+        }
+
+        out.assign(offset, 0);
+        std::memcpy(out.data(), &header, sizeof(header));
+        std::memcpy(out.data() + sizeof(header), table.data(), table.size() * sizeof(level_column_header));
+
+        for (size_t i = 0; i < columns.size(); ++i) {
+            std::memcpy(out.data() + table[i].entities_offset, columns[i].entities.data(), columns[i].entities.size() * sizeof(std::uint32_t));
+            std::memcpy(out.data() + table[i].data_offset, columns[i].data.data(), columns[i].data.size());
+        }
+
+        if (header.tilemap_offset != 0) {
+            unsigned char* section = out.data() + header.tilemap_offset;
+            std::memcpy(section, &tiles_header, sizeof(tiles_header));
+            section += sizeof(tiles_header);
+            std::memcpy(section, tilemap->types.data(), tilemap->types.size() * sizeof(tile_type));
+            section += tilemap->types.size() * sizeof(tile_type);
+            std::memcpy(section, tilemap->tiles.data(), tilemap->tiles.size() * sizeof(std::uint16_t));
+        }
+    }
+}
+
+namespace {
+    bool read_tilemap(const unsigned char* data, size_t size, std::uint64_t offset, Tilemap& tilemap) {
+        level_tilemap_header tiles_header;
+        if (offset + sizeof(tiles_header) > size) return false;
+        std::memcpy(&tiles_header, data + offset, sizeof(tiles_header));
+
+        if (tiles_header.width <= 0 || tiles_header.height <= 0 || tiles_header.type_count == 0 || tiles_header.tile_size <= 0.0f) return false;
+
+        std::uint64_t tile_count = static_cast<std::uint64_t>(tiles_header.width) * static_cast<std::uint64_t>(tiles_header.height);
+        std::uint64_t types_offset = offset + sizeof(tiles_header);
+        std::uint64_t tiles_offset = types_offset + static_cast<std::uint64_t>(tiles_header.type_count) * sizeof(tile_type);
+        if (tiles_offset + tile_count * sizeof(std::uint16_t) > size) return false;
+
+        tilemap = Tilemap(tiles_header.width, tiles_header.height, tiles_header.tile_size, tiles_header.origin_x, tiles_header.origin_y);
+        tilemap.types.resize(tiles_header.type_count);
+        std::memcpy(tilemap.types.data(), data + types_offset, tilemap.types.size() * sizeof(tile_type));
+        std::memcpy(tilemap.tiles.data(), data + tiles_offset, tilemap.tiles.size() * sizeof(std::uint16_t));
+        return true;
+    }
+}
+
+void cook_level(const level_data& level, std::vector<unsigned char>& out) {
+    //one column per component used by the level, in schema order
+    std::vector<cooked_column> columns;
+    for (auto& schema : component_schemas()) {
+        cooked_column current{ &schema, {}, {} };
+
+        for (size_t i = 0; i < level.entities.size(); ++i) {
+            for (auto& value : level.entities[i]) {
+                if (value.schema != &schema) continue;
+                current.entities.push_back(static_cast<std::uint32_t>(i));
+                current.data.insert(current.data.end(), value.bytes.begin(), value.bytes.end());
+            }
+        }
+
+        if (!current.entities.empty()) columns.push_back(std::move(current));
+    }
+
+    write_cooked(static_cast<std::uint32_t>(level.entities.size()), columns, &level.tilemap, out);
+}
+
+bool cook_level(const level_data& level, const std::string& path) {
+    std::vector<unsigned char> file_data;
+    cook_level(level, file_data);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        LOG_ERROR("Could not write level {}", path);
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(file_data.data()), static_cast<std::streamsize>(file_data.size()));
+    return static_cast<bool>(file);
+}
+
+void cook_entities(entity_manager& em, const std::vector<entity_handle>& ids, std::vector<unsigned char>& out) {
+    std::vector<cooked_column> columns;
+    for (auto& schema : component_schemas()) {
+        cooked_column current{ &schema, {}, {} };
+
+        for (size_t i = 0; i < ids.size(); ++i) {
+            const void* storage = em.get_component_storage(ids[i], schema.component_id);
+            if (!storage) continue;
+
+            const unsigned char* bytes = static_cast<const unsigned char*>(storage);
+            current.entities.push_back(static_cast<std::uint32_t>(i));
+            current.data.insert(current.data.end(), bytes, bytes + schema.size);
+        }
+
+        if (!current.entities.empty()) columns.push_back(std::move(current));
+    }
+
+    write_cooked(static_cast<std::uint32_t>(ids.size()), columns, nullptr, out);
+}
+
+size_t instantiate_level(entity_manager& em, const level_data& level) {
+    for (auto& components : level.entities) {
+        entity_handle id = em.new_entity();
+
+        for (auto& value : components) {
+            void* storage = em.assign_component_storage(id, value.schema->component_id, value.schema->size, value.schema->alignment);
+            std::memcpy(storage, value.bytes.data(), value.schema->size);
+            em.run_assign_hook(id, value.schema->component_id);
+        }
+    }
+    return level.entities.size();
+}
+
+bool read_cooked(const unsigned char* data, size_t size, cooked_level& level, std::string& error) {
+    level_file_header header;
+    if (size < sizeof(header)) {
+        error = "truncated";
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+
+    if (std::memcmp(header.magic, "LVLB", 4) != 0 || header.version != LEVEL_FILE_VERSION) {
+        error = "not a cooked level of version " + std::to_string(LEVEL_FILE_VERSION);
+        return false;
+    }
+
+    if (size < sizeof(header) + static_cast<size_t>(header.column_count) * sizeof(level_column_header)) {
+        error = "truncated";
+        return false;
+    }
+
+    //validate every column before anything uses it
+    level.schemas.assign(header.column_count, nullptr);
+    level.rows.assign(header.column_count, {});
+    level.columns.assign(header.column_count, component_column{});
+    for (std::uint32_t i = 0; i < header.column_count; ++i) {
+        level_column_header column;
+        std::memcpy(&column, data + sizeof(header) + i * sizeof(level_column_header), sizeof(level_column_header));
+        column.component[LEVEL_COMPONENT_NAME_SIZE - 1] = '\0';
+
+        const component_schema* schema = find_schema(column.component);
+        if (!schema || schema->size != column.element_size) {
+            error = std::string("component ") + column.component + " is unknown to this build, cook it again";
+            return false;
+        }
+
+        if (column.entities_offset + static_cast<std::uint64_t>(column.count) * sizeof(std::uint32_t) > size ||
+            column.data_offset + static_cast<std::uint64_t>(column.count) * column.element_size > size) {
+            error = "truncated";
+            return false;
+        }
+
+        std::vector<std::uint32_t>& rows = level.rows[i];
+        rows.resize(column.count);
+        if (column.count > 0) std::memcpy(rows.data(), data + column.entities_offset, static_cast<size_t>(column.count) * sizeof(std::uint32_t));
+
+        for (std::uint32_t index : rows) {
+            if (index >= header.entity_count) {
+                error = "entity " + std::to_string(index) + " out of " + std::to_string(header.entity_count);
+                return false;
+            }
+        }
+
+        level.schemas[i] = schema;
+        level.columns[i] = component_column{ schema->component_id, schema->size, schema->alignment, column.count, rows.data(), data + column.data_offset };
+    }
+
+    level.tilemap = Tilemap();
+    if (header.tilemap_offset != 0 && !read_tilemap(data, size, header.tilemap_offset, level.tilemap)) {
+        error = "truncated tilemap";
+        return false;
+    }
+
+    level.entity_count = header.entity_count;
+    return true;
+}
+
+void instantiate_cooked(entity_manager& em, const cooked_level& level) {
+    std::vector<entity_handle> ids;
+    em.new_entities(level.entity_count, ids);
+
+    //every column is handed over whole: pools are filled in one go and archetype entities placed once
+    em.assign_columns(ids, level.columns);
+}
+
+void split_cooked(const cooked_level& level, const std::vector<std::uint32_t>& group_of, std::vector<std::vector<unsigned char>>& groups) {
+    //index of every entity inside its group
+    std::vector<std::uint32_t> group_sizes(groups.size(), 0);
+    std::vector<std::uint32_t> local(level.entity_count);
+    for (std::uint32_t i = 0; i < level.entity_count; ++i) {
+        local[i] = group_sizes[group_of[i]]++;
+    }
+
+    //columns come in schema order, so a group's column for the current schema is always its last one
+    std::vector<std::vector<cooked_column>> group_columns(groups.size());
+    for (size_t c = 0; c < level.columns.size(); ++c) {
+        const component_column& column = level.columns[c];
+
+        for (size_t row = 0; row < column.count; ++row) {
+            std::uint32_t entity = column.rows[row];
+            std::vector<cooked_column>& target = group_columns[group_of[entity]];
+            if (target.empty() || target.back().schema != level.schemas[c]) {
+                target.push_back(cooked_column{ level.schemas[c], {}, {} });
+            }
+
+            const unsigned char* value = column.values + row * column.size;
+            target.back().entities.push_back(local[entity]);
+            target.back().data.insert(target.back().data.end(), value, value + column.size);
+        }
+    }
+
+    for (size_t g = 0; g < groups.size(); ++g) {
+        write_cooked(group_sizes[g], group_columns[g], nullptr, groups[g]);
+        group_columns[g] = std::vector<cooked_column>();
+    }
+}
+
+bool load_cooked(entity_manager& em, const unsigned char* data, size_t size, size_t& entity_count, std::string& error, Tilemap* tilemap) {
+    cooked_level level;
+    if (!read_cooked(data, size, level, error)) return false;
+
+    instantiate_cooked(em, level);
+
+    if (tilemap && !level.tilemap.empty()) {
+        *tilemap = std::move(level.tilemap);
+    }
+
+    entity_count = level.entity_count;
+    return true;
+}
+
+bool load_level_binary(entity_manager& em, const std::string& path, size_t& entity_count, Tilemap* tilemap) {
+    mapped_file file;
+    if (!file.open(path)) {
+        LOG_ERROR("Could not map level {}", path);
+        return false;
+    }
+
+    std::string error;
+    if (!load_cooked(em, file.data, file.size, entity_count, error, tilemap)) {
+        LOG_ERROR("Could not load level {}, {}", path, error);
+        return false;
+    }
+    return true;
+}
+
+namespace {
+    bool is_cooked_path(const std::string& path) {
+        const std::string cooked_extension = ".lvlb";
+        return path.size() >= cooked_extension.size() &&
+            path.compare(path.size() - cooked_extension.size(), cooked_extension.size(), cooked_extension) == 0;
+    }
+}
+
+bool with_cooked_level(const std::string& path, const std::function<bool(const unsigned char*, size_t)>& fn) {
+    if (is_cooked_path(path)) {
+        mapped_file file;
+        if (!file.open(path)) {
+            LOG_ERROR("Could not map level {}", path);
+            return false;
+        }
+        return fn(file.data, file.size);
+    }
+
+    level_data level;
+    if (!read_level_text(path, level)) return false;
+
+    std::vector<unsigned char> cooked;
+    cook_level(level, cooked);
+    level = level_data(); //only the cooked copy is needed from here on
+    return fn(cooked.data(), cooked.size());
+}
+
+bool load_level(entity_manager& em, const std::string& path, size_t& entity_count, Tilemap* tilemap) {
+    if (is_cooked_path(path)) {
+        return load_level_binary(em, path, entity_count, tilemap);
+    }
+
+    level_data level;
+    if (!read_level_text(path, level)) return false;
+
+    entity_count = instantiate_level(em, level);
+    if (tilemap && !level.tilemap.empty()) {
+        *tilemap = std::move(level.tilemap);
+    }
+    return true;
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "component_schema.h"
+#include "entity.h"
+#include "tilemap.h"
+
+#define LEVEL_FILE_VERSION 2
+#define LEVEL_COMPONENT_NAME_SIZE 32
+
+//level files come in two forms:
+//  text, written by hand. prefabs list components and field values, entities place a prefab:
+//      prefab enemy
+//          collision hitbox=0,0,30,30
+//          damage damage_amount=5
+//      end
+//      entity enemy 500 10 damage.damage_amount=10
+//    component.field=value overrides a field of the prefab (adding the component if the prefab
+//    doesn't have it), then the two numbers move the entity's position, sprite rect and hitbox.
+//    static geometry can also be drawn as a tilemap, one character per cell ('.' is empty,
+//    0-9 and a-z are tile ids) after the tile size and the world position of its top left corner:
+//      tile 1 solid color=0,0,255,255
+//      tile 2 solid damage=20
+//      tilemap 32 -500 600
+//      ....11111
+//      111111111
+//      end
+//  binary (.lvlb), cooked from the text by the level_cooker tool. it holds one column per
+//  component with the final bytes of every entity having it, loading memory maps the file and
+//  copies the columns into the entity_manager without parsing anything. the bytes are the
+//  in-memory layout of the components, so levels have to be cooked by a build of the same code
+
+struct component_value {
+    const component_schema* schema;
+    std::vector<unsigned char> bytes;
+};
+
+struct level_prefab {
+    std::string name;
+    std::vector<component_value> components;
+};
+
+//a parsed text level, every entity already has its final component values
+struct level_data {
+    std::vector<level_prefab> prefabs;
+    std::vector<std::vector<component_value>> entities;
+    Tilemap tilemap; //empty if the level has none
+};
+
+struct level_file_header {
+    char magic[4]; //"LVLB"
+    std::uint32_t version;
+    std::uint32_t entity_count;
+    std::uint32_t column_count;
+    std::uint64_t tilemap_offset; //level_tilemap_header, tile types and tile ids, 0 without a tilemap
+};
+
+struct level_tilemap_header {
+    std::int32_t width;
+    std::int32_t height;
+    float tile_size;
+    float origin_x;
+    float origin_y;
+    std::uint32_t type_count; //tile_type records before the width * height uint16 tile ids
+};
+
+struct level_column_header {
+    char component[LEVEL_COMPONENT_NAME_SIZE]; //schema name, ids change between builds
+    std::uint32_t element_size;
+    std::uint32_t count;
+    std::uint64_t entities_offset; //count uint32 entity indices, from the start of the file
+    std::uint64_t data_offset; //count components of element_size bytes
+};
+
+//false with a message in `error` ("line N: ...") when the text is malformed
+bool parse_level(const std::string& text, level_data& level, std::string& error);
+bool read_level_text(const std::string& path, level_data& level);
+
+bool cook_level(const level_data& level, const std::string& path);
+void cook_level(const level_data& level, std::vector<unsigned char>& out);
+
+//creates the entities of a parsed level, returns how many
+size_t instantiate_level(entity_manager& em, const level_data& level);
+
+//cooks the schema components of the given entities into `out`, in the cooked level format.
+//entity i of the blob is ids[i]
+void cook_entities(entity_manager& em, const std::vector<entity_handle>& ids, std::vector<unsigned char>& out);
+
+//a cooked level checked and decoded in place, its columns point into the data which has to outlive it
+struct cooked_level {
+    std::uint32_t entity_count = 0;
+    std::vector<const component_schema*> schemas; //of every column
+    std::vector<std::vector<std::uint32_t>> rows; //entity index of every value of a column
+    std::vector<component_column> columns;
+    Tilemap tilemap; //empty if the level has none
+};
+
+//false with a message in `error` if the data is malformed
+bool read_cooked(const unsigned char* data, size_t size, cooked_level& level, std::string& error);
+
+//creates the entities of a decoded level in one go
+void instantiate_cooked(entity_manager& em, const cooked_level& level);
+
+//cooks every group of entities into its own blob, entity i goes to groups[group_of[i]]. entities keep
+//their order inside a group, the tilemap isn't copied
+void split_cooked(const cooked_level& level, const std::vector<std::uint32_t>& group_of, std::vector<std::vector<unsigned char>>& groups);
+
+//creates the entities of a cooked level held in memory, false with a message in `error` if it's malformed.
+//its tilemap, if any, is copied into `tilemap` unless that is nullptr
+bool load_cooked(entity_manager& em, const unsigned char* data, size_t size, size_t& entity_count, std::string& error,
+    Tilemap* tilemap = nullptr);
+
+//memory maps a cooked level and copies its columns into em
+bool load_level_binary(entity_manager& em, const std::string& path, size_t& entity_count, Tilemap* tilemap = nullptr);
+
+//the cooked form of a level file: .lvlb files are memory mapped, text is parsed and cooked in memory.
+//fn(data, size) runs while the data is valid, false if the file couldn't be read or fn returned false
+bool with_cooked_level(const std::string& path, const std::function<bool(const unsigned char*, size_t)>& fn);
+
+//.lvlb files are loaded as cooked levels, anything else as text
+bool load_level(entity_manager& em, const std::string& path, size_t& entity_count, Tilemap* tilemap = nullptr);
@@ -0,0 +1,128 @@
+#include "logger.h"
+#include <chrono>
+#include <cstdio>
+
+namespace {
+    const char* level_name(int level) {
+        switch (level) {
+        case LOG_LEVEL_TRACE: return "trace";
+        case LOG_LEVEL_DEBUG: return "debug";
+        case LOG_LEVEL_INFO: return "info";
+        case LOG_LEVEL_WARN: return "warning";
+        default: return "error";
+        }
+    }
+}
+
+Logger& Logger::get() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger() : start_time(SDL_GetPerformanceCounter()) {
+    writer = std::thread(&Logger::writer_loop, this);
+}
+
+Logger::~Logger() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake_up.notify_all();
+    writer.join();
+}
+
+Logger::log_ring& Logger::thread_ring() {
+    //created the first time the thread logs
+    thread_local log_ring* ring = nullptr;
+    if (!ring) {
+        std::lock_guard<std::mutex> guard(lock);
+        rings.push_back(std::make_unique<log_ring>());
+        ring = rings.back().get();
+    }
+    return *ring;
+}
+
+void Logger::push(const log_record& record) {
+    if (thread_ring().push(record)) {
+        pushed.fetch_add(1, std::memory_order_release);
+    }
+    else {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Logger::flush() {
+    unsigned long long target = pushed.load(std::memory_order_acquire);
+
+    std::unique_lock<std::mutex> guard(lock);
+    wake_up.notify_all();
+    wake_up.wait(guard, [&]() { return written >= target; });
+}
+
+void Logger::writer_loop() {
+    std::unique_lock<std::mutex> guard(lock);
+    while (true) {
+        wake_up.wait_for(guard, std::chrono::milliseconds(LOG_FLUSH_INTERVAL_MS));
+        bool stop = stopping;
+
+        guard.unlock();
+        bool wrote = write_pending();
+        guard.lock();
+
+        if (wrote) wake_up.notify_all();
+        if (stop) return;
+    }
+}
+
+bool Logger::write_pending() {
+    batch.clear();
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (auto& thread_records : rings) {
+            thread_records->drain([&](const log_record& record) { batch.push_back(record); });
+        }
+    }
+    if (batch.empty()) return false;
+
+    //every ring is in order on its own, merged by time they read as one log
+    std::stable_sort(batch.begin(), batch.end(), [](const log_record& a, const log_record& b) { return a.time < b.time; });
+
+    const double frequency = static_cast<double>(SDL_GetPerformanceFrequency());
+    char number[64];
+
+    for (auto& record : batch) {
+        std::snprintf(number, sizeof(number), "[%10.4f] %s: ", static_cast<double>(record.time - start_time) / frequency, level_name(record.level));
+        line = number;
+
+        std::uint8_t argument = 0;
+        for (const char* c = record.format; *c; ++c) {
+            if (c[0] != '{' || c[1] != '}' || argument >= record.argument_count) {
+                line += *c;
+                continue;
+            }
+
+            const log_record::argument& value = record.arguments[argument];
+            switch (record.types[argument]) {
+            case log_record::SIGNED: std::snprintf(number, sizeof(number), "%lld", value.signed_value); line += number; break;
+            case log_record::UNSIGNED: std::snprintf(number, sizeof(number), "%llu", value.unsigned_value); line += number; break;
+            case log_record::REAL: std::snprintf(number, sizeof(number), "%g", value.real_value); line += number; break;
+            case log_record::TEXT: line += record.text + value.text_offset; break;
+            }
+
+            ++argument;
+            ++c;
+        }
+        line += '\n';
+
+        std::FILE* stream = record.level >= LOG_LEVEL_WARN ? stderr : stdout;
+        std::fwrite(line.data(), 1, line.size(), stream);
+    }
+
+    std::fflush(stdout);
+    std::fflush(stderr);
+
+    std::lock_guard<std::mutex> guard(lock);
+    written += batch.size();
+    return true;
+}
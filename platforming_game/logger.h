@@ -0,0 +1,156 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "spsc_ring.h"
+
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_WARN 3
+#define LOG_LEVEL_ERROR 4
+#define LOG_LEVEL_OFF 5
+
+//calls below this level are compiled out, their arguments aren't even evaluated
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_RING_SIZE 1024 //records buffered per thread until the logger thread gets to them, a power of two
+#define LOG_MAX_ARGUMENTS 6
+#define LOG_TEXT_BYTES 96 //string arguments of a record share this many bytes, longer ones are cut
+#define LOG_FLUSH_INTERVAL_MS 10 //how often the logger thread wakes up to format what was recorded
+
+//one log call, kept binary until the logger thread formats it. the format has to be a string
+//literal, it is only read by the logger thread. "{}" in it is replaced by the next argument
+struct log_record {
+    enum argument_type : std::uint8_t { SIGNED, UNSIGNED, REAL, TEXT };
+
+    union argument {
+        long long signed_value;
+        unsigned long long unsigned_value;
+        double real_value;
+        std::uint16_t text_offset; //into text, the string is null terminated
+    };
+
+    Uint64 time;
+    const char* format;
+    std::uint8_t level;
+    std::uint8_t argument_count;
+    std::uint8_t types[LOG_MAX_ARGUMENTS];
+    argument arguments[LOG_MAX_ARGUMENTS];
+    char text[LOG_TEXT_BYTES];
+};
+
+//asynchronous logger: hot paths only copy their arguments into a record on their thread's ring,
+//a background thread formats the records and writes them, errors and warnings to stderr and the
+//rest to stdout. records that don't fit in a full ring are dropped and counted, logging never blocks
+class Logger {
+public:
+    static Logger& get();
+    ~Logger();
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    template<class... Args>
+    void log(int level, const char* format, const Args&... arguments) {
+        static_assert(sizeof...(Args) <= LOG_MAX_ARGUMENTS, "too many log arguments");
+
+        log_record record;
+        record.time = SDL_GetPerformanceCounter();
+        record.format = format;
+        record.level = static_cast<std::uint8_t>(level);
+        record.argument_count = 0;
+
+        [[maybe_unused]] size_t text_used = 0; //unread when no argument is a string
+        (encode(record, text_used, arguments), ...);
+        push(record);
+    }
+
+    //returns once every record logged before the call is written
+    void flush();
+
+    //records lost because a ring was full
+    size_t dropped_records() const {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    using log_ring = spsc_ring<log_record, LOG_RING_SIZE>;
+
+    Logger();
+
+    template<class T>
+    static void encode(log_record& record, size_t& text_used, const T& value) {
+        std::uint8_t index = record.argument_count++;
+
+        if constexpr (std::is_integral<T>::value && std::is_signed<T>::value) {
+            record.types[index] = log_record::SIGNED;
+            record.arguments[index].signed_value = static_cast<long long>(value);
+        }
+        else if constexpr (std::is_integral<T>::value || std::is_enum<T>::value) {
+            record.types[index] = log_record::UNSIGNED;
+            record.arguments[index].unsigned_value = static_cast<unsigned long long>(value);
+        }
+        else if constexpr (std::is_floating_point<T>::value) {
+            record.types[index] = log_record::REAL;
+            record.arguments[index].real_value = static_cast<double>(value);
+        }
+        else if constexpr (std::is_same<T, std::string>::value) {
+            encode_text(record, text_used, index, value.c_str(), value.size());
+        }
+        else {
+            static_assert(std::is_convertible<const T&, const char*>::value, "log arguments are numbers or strings");
+            const char* text = value;
+            if (!text) text = "(null)";
+            encode_text(record, text_used, index, text, std::strlen(text));
+        }
+    }
+
+    static void encode_text(log_record& record, size_t& text_used, std::uint8_t index, const char* text, size_t length) {
+        size_t available = text_used < LOG_TEXT_BYTES ? LOG_TEXT_BYTES - text_used - 1 : 0;
+        length = std::min(length, available);
+
+        record.types[index] = log_record::TEXT;
+        record.arguments[index].text_offset = static_cast<std::uint16_t>(std::min<size_t>(text_used, LOG_TEXT_BYTES - 1));
+        std::memcpy(record.text + record.arguments[index].text_offset, text, length);
+        record.text[record.arguments[index].text_offset + length] = '\0';
+        text_used += length + 1;
+    }
+
+    void push(const log_record& record);
+    log_ring& thread_ring();
+    void writer_loop();
+    bool write_pending(); //formats and writes everything recorded so far, false if nothing was
+
+    std::mutex lock; //guards rings and the written counter, never taken while recording
+    std::vector<std::unique_ptr<log_ring>> rings; //one per thread that logged, kept until the logger goes away
+    std::atomic<size_t> dropped{ 0 };
+    std::atomic<unsigned long long> pushed{ 0 };
+    unsigned long long written = 0; //records formatted and written by the logger thread
+
+    std::condition_variable wake_up; //flush wakes the logger thread up early and waits for it here
+    bool stopping = false;
+    std::vector<log_record> batch; //records of one pass, sorted by time before formatting
+    std::string line;
+    Uint64 start_time; //performance counter value printed as time 0
+    std::thread writer;
+};
+
+#define LOG_AT(level, ...) do { if constexpr ((level) >= LOG_LEVEL) Logger::get().log((level), __VA_ARGS__); } while (0)
+
+#define LOG_TRACE(...) LOG_AT(LOG_LEVEL_TRACE, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARN(...) LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
@@ -1,12 +1,34 @@
 #include <iostream>
 #include <array>
+#include <cstring>
+#include <string>
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_image.h>
 #include "game.h"
 
 int main(int argc, char* argv[]) {
+	simulation_settings settings;
+	std::string level_path = "levels/level1.txt";
 
-	Game game;
+	//--broadphase grid|sap|brute picks the collision broadphase at startup
+	for (int i = 1; i + 1 < argc; ++i) {
+		if (std::strcmp(argv[i], "--broadphase") == 0) {
+			const char* type = argv[i + 1];
+			if (std::strcmp(type, "sap") == 0) settings.collision.type = broadphase_type::SWEEP_AND_PRUNE;
+			else if (std::strcmp(type, "brute") == 0) settings.collision.type = broadphase_type::BRUTE_FORCE;
+			else settings.collision.type = broadphase_type::SPATIAL_HASH;
+		}
+		//--stream-dir writes the chunks far from the player to this directory instead of a temporary one
+		else if (std::strcmp(argv[i], "--stream-dir") == 0) {
+			settings.streaming.directory = argv[i + 1];
+		}
+		//--level loads another text or cooked level file
+		else if (std::strcmp(argv[i], "--level") == 0) {
+			level_path = argv[i + 1];
+		}
+	}
+
+	Game game(settings, level_path);
 
 	game.run();
 
@@ -1,95 +1,701 @@
 #include "movement.h"
 
-Movement_System::Movement_System(entity_manager& em, Input_Handler& input, Collision_System& collision_system) : em(em), input(input){}
+#define MOVEMENT_GRAIN 1024 //entities integrated per parallel job
+
+namespace {
+    //box covering a hitbox at both ends of a step
+    SDL_FRect swept_box(types::Vec2<double> from, types::Vec2<double> to, const SDL_FRect& hitbox) {
+        float left = static_cast<float>(std::min(from.x, to.x));
+        float top = static_cast<float>(std::min(from.y, to.y));
+        float right = static_cast<float>(std::max(from.x, to.x)) + hitbox.w;
+        float bottom = static_cast<float>(std::max(from.y, to.y)) + hitbox.h;
+        return { left, top, right - left, bottom - top };
+    }
 
-Collision_System::Collision_System(entity_manager& em) : em(em) {}
+    //integrates bodies [begin, end) a batch at a time, writing them back along with their hitboxes.
+    //get(i) returns the position, movement, gravity and collision of body i, the last two nullptr when missing
+    template<class Get>
+    void integrate_bulk(size_t begin, size_t end, double delta_time, simd_isa isa, Get&& get) {
+        body_batch batch;
+        components::position* positions[BODY_BATCH_SIZE];
+        components::movement* movements[BODY_BATCH_SIZE];
+        components::collision* collisions[BODY_BATCH_SIZE];
+
+        for (size_t first = begin; first < end; first += BODY_BATCH_SIZE) {
+            batch.count = std::min<size_t>(BODY_BATCH_SIZE, end - first);
+
+            for (size_t i = 0; i < batch.count; ++i) {
+                auto [position, movement, gravity, collision] = get(first + i);
+                positions[i] = position;
+                movements[i] = movement;
+                collisions[i] = collision;
+
+                batch.x[i] = position->pos.x;
+                batch.y[i] = position->pos.y;
+                batch.speed_x[i] = movement->speed.x;
+                batch.speed_y[i] = movement->speed.y;
+                batch.max_speed_y[i] = movement->max_speed.y;
+                batch.gravity[i] = gravity ? gravity->falling_strength : 0.0;
+            }
 
-void Movement_System::update(double delta_time) {
+            integrate_bodies(batch, delta_time, delta_time / SPEED_TIME_UNIT, isa);
 
-    for (auto& e : em.entities) {
-        if (e.mask.test(components::get_id<components::movement>())) {
-            auto* position = em.get_component<components::position>(e.id);
-            auto* movement = em.get_component<components::movement>(e.id);
+            for (size_t i = 0; i < batch.count; ++i) {
+                positions[i]->previous_pos = positions[i]->pos;
+                positions[i]->pos = { batch.x[i], batch.y[i] };
+                movements[i]->speed.y = batch.speed_y[i];
 
-            // Apply gravity
-            if (e.mask.test(components::get_id<components::gravity>())) {
-                auto* gravity_component = em.get_component<components::gravity>(e.id);
-                movement->speed.y += gravity_component->falling_strength * delta_time;
+                if (collisions[i]) {
+                    collisions[i]->hitbox.x = static_cast<float>(batch.x[i]);
+                    collisions[i]->hitbox.y = static_cast<float>(batch.y[i]);
+                }
             }
+        }
+    }
 
-            // Handle input (after collision detection)
-            if (e.mask.test(components::get_id<components::input>())) {
-                auto* key_binds = em.get_component<components::input>(e.id);
+    //same steps as integrate_bodies straight on the columns of an archetype chunk of falling bodies
+    void integrate_columns(size_t count, double delta_time, components::position* positions, components::movement* movements,
+        const components::gravity* gravities, components::collision* collisions) {
+        double scale = delta_time / SPEED_TIME_UNIT;
 
-                if (input.is_key_pressed(key_binds->move_left)) {
-                    double key_press_duration = input.key_time(SDL_SCANCODE_A);
-                    movement->speed.x -= movement->acceleration.x * key_press_duration * delta_time;
-                }
+        for (size_t i = 0; i < count; ++i) {
+            double speed_y = movements[i].speed.y + gravities[i].falling_strength * delta_time;
+            speed_y = std::min(std::max(speed_y, -movements[i].max_speed.y), movements[i].max_speed.y);
+            movements[i].speed.y = speed_y;
+
+            positions[i].previous_pos = positions[i].pos;
+            positions[i].pos.x += movements[i].speed.x * scale;
+            positions[i].pos.y += speed_y * scale;
+
+            collisions[i].hitbox.x = static_cast<float>(positions[i].pos.x);
+            collisions[i].hitbox.y = static_cast<float>(positions[i].pos.y);
+        }
+    }
+}
+
+//earliest time in [0, 1] at which a w * h box at `start` moving by `motion` starts overlapping `target`
+//(slab test against the target grown by the box size) and the normal of the face it hits. touching
+//counts as a hit, a box already overlapping the target at the start doesn't
+bool sweep_box(types::Vec2<double> start, double w, double h, types::Vec2<double> motion, const SDL_FRect& target, sweep_hit& hit) {
+    const double infinity = std::numeric_limits<double>::infinity();
+
+    auto slab = [&](double from, double delta, double low, double high, double& entry, double& exit) {
+        if (delta == 0.0) {
+            if (from <= low || from >= high) return false;
+            entry = -infinity;
+            exit = infinity;
+            return true;
+        }
+
+        double first = (low - from) / delta;
+        double second = (high - from) / delta;
+        entry = std::min(first, second);
+        exit = std::max(first, second);
+        return true;
+    };
+
+    double entry_x, exit_x, entry_y, exit_y;
+    if (!slab(start.x, motion.x, target.x - w, target.x + target.w, entry_x, exit_x)) return false;
+    if (!slab(start.y, motion.y, target.y - h, target.y + target.h, entry_y, exit_y)) return false;
+
+    double entry = std::max(entry_x, entry_y);
+    double exit = std::min(exit_x, exit_y);
+    if (entry >= exit || entry < 0.0 || entry > 1.0) return false;
+
+    hit.time = entry;
+    if (entry_x > entry_y) hit.normal = { motion.x > 0.0 ? -1.0 : 1.0, 0.0 };
+    else hit.normal = { 0.0, motion.y > 0.0 ? -1.0 : 1.0 };
+    return true;
+}
+
+Movement_System::Movement_System(entity_manager& em, Input_Handler& input, Collision_System& collision_system, Thread_Pool* pool) : em(em), input(input), pool(pool) {}
+
+system_access Movement_System::access() {
+    system_access access;
+    access.reads = component_mask<components::gravity, components::input, components::jump>();
+    access.writes = component_mask<components::position, components::movement, components::collision>();
+    return access;
+}
+
+Collision_System::Collision_System(entity_manager& em, broadphase_settings settings) : em(em), damage_events(em.events<damage_event>()), settings(settings), broadphase(make_broadphase(settings)) {
+    em.set_component_hooks<components::collision>(nullptr, &remove_body, this);
+}
+
+Collision_System::~Collision_System() {
+    em.set_component_hooks<components::collision>(nullptr, nullptr, nullptr);
+}
+
+system_access Collision_System::access() {
+    system_access access;
+    access.reads = component_mask<components::health, components::damage, components::input, components::asleep>();
+    access.writes = component_mask<components::position, components::movement, components::collision>();
+    return access;
+}
 
-                if (input.is_key_pressed(key_binds->move_right)) {
-                    double key_press_duration = input.key_time(SDL_SCANCODE_D);
-                    movement->speed.x += movement->acceleration.x * key_press_duration * delta_time;
+void Movement_System::update(double delta_time) {
+
+    if (em.mode == storage_mode::ARCHETYPE) {
+        //walk the movement columns chunk by chunk, optional components are either present for the whole chunk or not at all
+        std::bitset<MAX_COMPONENTS> required = component_mask<components::position, components::movement>();
+        std::bitset<MAX_COMPONENTS> excluded = component_mask<components::asleep>();
+
+        chunks.clear();
+        em.for_each_chunk(required, excluded, [&](chunk_view& chunk) {
+            chunks.push_back(chunk);
+        });
+
+        auto integrate_chunks = [&](size_t begin, size_t end) {
+            for (size_t c = begin; c < end; ++c) {
+                chunk_view& chunk = chunks[c];
+                auto* positions = chunk.column<components::position>(components::get_id<components::position>());
+                auto* movements = chunk.column<components::movement>(components::get_id<components::movement>());
+                auto* gravities = chunk.column<components::gravity>(components::get_id<components::gravity>());
+                auto* key_binds = chunk.column<components::input>(components::get_id<components::input>());
+                auto* jumps = chunk.column<components::jump>(components::get_id<components::jump>());
+                auto* collisions = chunk.column<components::collision>(components::get_id<components::collision>());
+
+                //the columns are contiguous already, copying them into a batch costs more than SIMD saves
+                if (bulk_enabled && !key_binds && gravities && collisions) {
+                    integrate_columns(chunk.size(), delta_time, positions, movements, gravities, collisions);
+                    continue;
                 }
 
-                if (!input.is_key_pressed(key_binds->move_left) && !input.is_key_pressed(key_binds->move_right)) {
-                    if (std::abs(movement->speed.x) < 0.01) {
-                        movement->speed.x = 0;  // Detener completamente si es muy baja
-                    }
-                    else if (movement->speed.x > 0) {
-                        movement->speed.x -= movement->deceleration.x * delta_time;
-                        if (movement->speed.x < 0) movement->speed.x = 0;  // Evita moverse en reversa
-                    }
-                    else if (movement->speed.x < 0) {
-                        movement->speed.x += movement->deceleration.x * delta_time;
-                        if (movement->speed.x > 0) movement->speed.x = 0;  // Evita moverse en reversa
-                    }
+                for (size_t i = 0; i < chunk.size(); ++i) {
+                    integrate(delta_time, &positions[i], &movements[i],
+                        gravities ? &gravities[i] : nullptr,
+                        key_binds ? &key_binds[i] : nullptr,
+                        jumps ? &jumps[i] : nullptr,
+                        collisions ? &collisions[i] : nullptr);
                 }
+            }
+        };
 
+        if (pool) pool->parallel_for(0, chunks.size(), 1, integrate_chunks);
+        else integrate_chunks(0, chunks.size());
+        return;
+    }
 
-                if (std::abs(movement->speed.x) > movement->max_speed.x) {
-                    float sign = std::signbit(movement->speed.x) ? -1.0f : 1.0f;
-                    movement->speed.x = movement->max_speed.x * sign;
-                }
+    if (bulk_enabled) {
+        //bodies without input only fall and move, they are integrated in batches and only the input
+        //driven ones take the branching path
+        auto falling = em.view<components::position, components::movement, query::exclude<components::asleep>,
+            query::exclude<components::input>, query::optional<components::gravity>, query::optional<components::collision>>();
+
+        auto integrate_falling = [&](size_t begin, size_t end) {
+            integrate_bulk(begin, end, delta_time, bulk_isa, [&](size_t i) {
+                auto [id, position, movement, gravity, collision] = falling.get(i);
+                return std::make_tuple(&position, &movement, gravity, collision);
+            });
+        };
+
+        if (pool) pool->parallel_for(0, falling.size(), MOVEMENT_GRAIN, integrate_falling);
+        else integrate_falling(0, falling.size());
+
+        auto driven = em.view<components::position, components::movement, components::input, query::exclude<components::asleep>,
+            query::optional<components::gravity>, query::optional<components::jump>, query::optional<components::collision>>();
+        for (auto [id, position, movement, key_binds, gravity, jump, collision] : driven) {
+            integrate(delta_time, &position, &movement, gravity, &key_binds, jump, collision);
+        }
+        return;
+    }
 
-                if (e.mask.test(components::get_id<components::jump>())) {
-                    auto* jump_component = em.get_component<components::jump>(e.id);
+    auto moving = em.view<components::position, components::movement, query::exclude<components::asleep>,
+        query::optional<components::gravity>, query::optional<components::input>,
+        query::optional<components::jump>, query::optional<components::collision>>();
 
-                    if (input.is_key_pressed(key_binds->jump) && position->is_grounded) {
-                        movement->speed.y = jump_component->jump_strength;
-                        position->is_grounded = false;
-                    }
+    //every entity only touches its own components, so the ranges can run in any order on any thread
+    auto integrate_range = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            auto [id, position, movement, gravity, key_binds, jump, collision] = moving.get(i);
+            integrate(delta_time, &position, &movement, gravity, key_binds, jump, collision);
+        }
+    };
 
-                    if (input.is_key_released(key_binds->jump) && !position->is_grounded) {
-                        movement->speed.y *= 0.5;
-                    }
-                }
+    if (pool) pool->parallel_for(0, moving.size(), MOVEMENT_GRAIN, integrate_range);
+    else integrate_range(0, moving.size());
+}
+
+void Movement_System::integrate(double delta_time, components::position* position, components::movement* movement,
+    components::gravity* gravity_component, components::input* key_binds, components::jump* jump_component, components::collision* collision_component) {
+
+    // Apply gravity
+    if (gravity_component) {
+        movement->speed.y += gravity_component->falling_strength * delta_time;
+    }
+
+    // Handle input (after collision detection)
+    if (key_binds) {
+        if (input.is_key_pressed(key_binds->move_left)) {
+            double key_press_duration = input.key_time(SDL_SCANCODE_A);
+            movement->speed.x -= movement->acceleration.x * key_press_duration * delta_time;
+        }
+
+        if (input.is_key_pressed(key_binds->move_right)) {
+            double key_press_duration = input.key_time(SDL_SCANCODE_D);
+            movement->speed.x += movement->acceleration.x * key_press_duration * delta_time;
+        }
+
+        if (!input.is_key_pressed(key_binds->move_left) && !input.is_key_pressed(key_binds->move_right)) {
+            if (std::abs(movement->speed.x) < 0.01) {
+                movement->speed.x = 0;  // Detener completamente si es muy baja
+            }
+            else if (movement->speed.x > 0) {
+                movement->speed.x -= movement->deceleration.x * delta_time;
+                if (movement->speed.x < 0) movement->speed.x = 0;  // Evita moverse en reversa
+            }
+            else if (movement->speed.x < 0) {
+                movement->speed.x += movement->deceleration.x * delta_time;
+                if (movement->speed.x > 0) movement->speed.x = 0;  // Evita moverse en reversa
+            }
+        }
+
+
+        if (std::abs(movement->speed.x) > movement->max_speed.x) {
+            float sign = std::signbit(movement->speed.x) ? -1.0f : 1.0f;
+            movement->speed.x = movement->max_speed.x * sign;
+        }
+
+        if (jump_component) {
+            if (input.is_key_pressed(key_binds->jump) && position->is_grounded) {
+                movement->speed.y = jump_component->jump_strength;
+                position->is_grounded = false;
+            }
+
+            if (input.is_key_released(key_binds->jump) && !position->is_grounded) {
+                movement->speed.y *= 0.5;
+            }
+        }
+    }
+
+    if (std::abs(movement->speed.y) > movement->max_speed.y) {
+        float sign = std::signbit(movement->speed.y) ? -1.0f : 1.0f;
+        movement->speed.y = movement->max_speed.y * sign;
+    }
+
+    //apply the final position, scaled by the step so the distance travelled doesn't depend on the step rate
+    position->previous_pos = position->pos;
+    position->pos.x += movement->speed.x * (delta_time / SPEED_TIME_UNIT);
+    position->pos.y += movement->speed.y * (delta_time / SPEED_TIME_UNIT);
+
+    if (collision_component) {
+        collision_component->hitbox.x = position->pos.x;
+        collision_component->hitbox.y = position->pos.y;
+    }
+}
+
+void Collision_System::update() {
+    if (!static_tier_built) {
+        build_static_tier();
+    }
+
+    wake_unsupported();
+
+    //the broadphase sees the whole path of every body this step, so fast bodies still pair up
+    {
+        PROFILE_SCOPE("collision/broadphase");
+        bodies.clear();
+        for (auto [id, collision, movement, position] : em.view<components::collision, components::movement, query::optional<components::position>>()) {
+            bodies.push_back(broadphase_body{ id, position ? swept_box(position->previous_pos, position->pos, collision.hitbox) : collision.hitbox });
+        }
+
+        broadphase->update(bodies);
+    }
+
+    //rigid static geometry and tiles are swept, the bodies end up touching instead of overlapping them
+    {
+        PROFILE_SCOPE("collision/sweep");
+        swept_pairs.clear();
+        sweep_bodies();
+        std::sort(swept_pairs.begin(), swept_pairs.end());
+    }
+
+    PROFILE_SCOPE("collision/contacts");
+    contacts.clear();
+
+    //static bodies are only reached through the static tier, so static-static pairs never come up.
+    //what is left overlapping after the sweep: non rigid bodies like damage zones, or bodies that started inside
+    for (auto [id, collision, movement] : em.view<components::collision, components::movement, query::exclude<components::asleep>>()) {
+        entity_handle dynamic_id = id;
+        static_tier.query(collision.hitbox, [&](const broadphase_body& body) {
+            if (!em.has_component<components::collision>(body.id)) return;
+            if (std::binary_search(swept_pairs.begin(), swept_pairs.end(), body_pair(dynamic_id, body.id))) return;
+            contacts.emplace_back(dynamic_id, body.id);
+        });
+    }
+
+    for (auto& pair : broadphase->candidate_pairs()) {
+        if (wake_on_contact(pair.first, pair.second)) {
+            contacts.push_back(pair);
+        }
+    }
+
+    process_contacts();
+    update_sleep();
+}
+
+void Collision_System::build_static_tier() {
+    bodies.clear();
+    for (auto [id, collision] : em.view<components::collision, query::exclude<components::movement>>()) {
+        bodies.push_back(broadphase_body{ id, collision.hitbox });
+    }
+
+    static_tier.build(bodies);
+    static_tier_built = true;
+}
+
+//static bodies going away leave the tier stale, it is rebuilt on the next update. the box of every removed
+//body is kept until then, sleepers resting on it have to wake up and fall
+void Collision_System::remove_body(void* context, entity_manager& em, entity_handle id) {
+    auto* system = static_cast<Collision_System*>(context);
+    if (!em.has_component<components::movement>(id)) {
+        system->static_tier_built = false;
+    }
+    system->removed_bodies.push_back(broadphase_body{ id, em.get_component<components::collision>(id)->hitbox });
+}
+
+//sleepers don't move, so nothing else notices when what they rest on (or lean against) is deleted or streamed out
+void Collision_System::wake_unsupported() {
+    if (removed_bodies.empty()) return;
+
+    removed_tier.build(removed_bodies);
+    removed_bodies.clear();
+
+    for (auto [id, collision, asleep] : em.view<components::collision, components::asleep>()) {
+        bool touched = false;
+        removed_tier.query(collision.hitbox, [&](const broadphase_body&) {
+            touched = true;
+        });
+
+        if (touched) wake(id);
+    }
+
+    removed_tier.clear();
+}
+
+void Collision_System::wake(entity_handle id) {
+    em.deferred().remove_component<components::asleep>(id);
+    if (auto* movement = em.get_component<components::movement>(id)) {
+        movement->idle_frames = 0;
+    }
+}
+
+//decides if a pair of dynamic bodies goes to the narrowphase, waking up a sleeping body touched by an awake one
+bool Collision_System::wake_on_contact(entity_handle first, entity_handle second) {
+    bool first_asleep = em.has_component<components::asleep>(first);
+    bool second_asleep = em.has_component<components::asleep>(second);
+
+    if (!first_asleep && !second_asleep) return true;
+    if (first_asleep && second_asleep) return false;
+
+    if (detect_collision(first, second) == collision_direction::NO_COLLISION) {
+        return false;
+    }
+
+    wake(first_asleep ? first : second);
+    return true;
+}
+
+void Collision_System::update_sleep() {
+    //bodies driven by input can start moving without anything touching them, so they never sleep
+    auto candidates = em.view<components::movement, components::collision,
+        query::exclude<components::asleep>, query::exclude<components::input>>();
+
+    for (auto [id, movement, collision] : candidates) {
+        if (std::abs(movement.speed.x) < settings.sleep_speed_threshold &&
+            std::abs(movement.speed.y) < settings.sleep_speed_threshold) {
+            movement.idle_frames++;
+        }
+        else {
+            movement.idle_frames = 0;
+        }
+
+        if (movement.idle_frames >= settings.sleep_frames) {
+            movement.speed = { 0.0, 0.0 };
+            em.deferred().add_component<components::asleep>(id);
+
+            //sleeping bodies aren't integrated, so nothing would catch previous_pos up with pos
+            if (auto* position = em.get_component<components::position>(id)) {
+                position->previous_pos = position->pos;
             }
+        }
+    }
+}
 
-            if (std::abs(movement->speed.y) > movement->max_speed.y) {
-                float sign = std::signbit(movement->speed.y) ? -1.0f : 1.0f;
-                movement->speed.y = movement->max_speed.x * sign;
+void Collision_System::sweep_bodies() {
+    auto movers = em.view<components::collision, components::movement, components::position,
+        query::exclude<components::asleep>, query::optional<components::health>>();
+
+    for (auto [id, collision, movement, position, health] : movers) {
+        int tile_damage = sweep(id, position, movement, collision);
+
+        if (!tilemap || tilemap->empty()) {
+            if (health && tile_damage > 0) damage_events.send(damage_event{ id, entity_handle(), tile_damage });
+            continue;
+        }
+
+        //damage is looked up before pushing the body out, afterwards it only touches the tiles it rests on
+        int first_column, first_row, last_column, last_row;
+        if (health && tilemap->cell_range(collision.hitbox, first_column, first_row, last_column, last_row)) {
+            for (int row = first_row; row <= last_row; ++row) {
+                for (int column = first_column; column <= last_column; ++column) {
+                    tile_damage = std::max(tile_damage, tilemap->type(tilemap->get(column, row)).damage);
+                }
             }
+        }
+
+        //touching several damaging tiles hurts as much as the worst of them, not once per tile
+        if (health && tile_damage > 0) {
+            damage_events.send(damage_event{ id, entity_handle(), tile_damage });
+        }
+
+        //bodies that started the step inside tiles aren't caught by the sweep
+        for (int pass = 0; pass < TILE_RESOLVE_PASSES; ++pass) {
+            if (!push_out_of_tiles(position, movement, collision)) break;
+        }
+    }
+}
+
+//moves the body from previous_pos to pos, stopping at the first rigid static body or solid tile face in
+//the way and sliding along it with what is left of the motion. returns the worst damage of the tiles hit
+int Collision_System::sweep(entity_handle id, components::position& position, components::movement& movement, components::collision& collision) {
+    types::Vec2<double> start = position.previous_pos;
+    types::Vec2<double> motion = { position.pos.x - start.x, position.pos.y - start.y };
+    if (!settings.continuous || (motion.x == 0.0 && motion.y == 0.0)) return 0;
+
+    const SDL_FRect& box = collision.hitbox;
+    SDL_FRect path = swept_box(start, position.pos, box);
+
+    //every later iteration moves inside the box of the first one, candidates are gathered once
+    sweep_candidates.clear();
+    static_tier.query(path, [&](const broadphase_body& body) {
+        auto* other = em.get_component<components::collision>(body.id);
+        if (other && (other->is_rigid || collision.is_rigid)) {
+            sweep_candidates.push_back(body);
+        }
+    });
+
+    int first_column = 0, first_row = 0, last_column = -1, last_row = -1;
+    if (tilemap) {
+        tilemap->cell_range(path, first_column, first_row, last_column, last_row);
+    }
+
+    int tile_damage = 0;
+
+    for (int iteration = 0; iteration < CCD_ITERATIONS; ++iteration) {
+        sweep_hit earliest;
+
+        auto consider = [&](const SDL_FRect& target, entity_handle hit_id, int damage) {
+            sweep_hit hit;
+            if (!sweep_box(start, box.w, box.h, motion, target, hit)) return false;
+            if (earliest.time >= 0.0 && earliest.time <= hit.time) return false;
+
+            hit.id = hit_id;
+            hit.damage = damage;
+            earliest = hit;
+            return true;
+        };
+
+        for (auto& candidate : sweep_candidates) {
+            consider(candidate.box, candidate.id, 0);
+        }
 
-            //apply the final position
-            position->pos.x += movement->speed.x;
-            position->pos.y += movement->speed.y;
+        for (int row = first_row; row <= last_row; ++row) {
+            for (int column = first_column; column <= last_column; ++column) {
+                if (!tilemap->solid(column, row)) continue;
 
-            if (e.mask.test(components::get_id<components::collision>())) {
-                auto* collision_component = em.get_component<components::collision>(e.id);
+                sweep_hit before = earliest;
+                if (!consider(tilemap->cell_rect(column, row), id, tilemap->type(tilemap->get(column, row)).damage)) continue;
 
-                collision_component->hitbox.x = position->pos.x;
-                collision_component->hitbox.y = position->pos.y;
+                //faces shared with another solid tile can't be hit, they are inside the geometry
+                if (tilemap->solid(column + static_cast<int>(earliest.normal.x), row + static_cast<int>(earliest.normal.y))) {
+                    earliest = before;
+                }
             }
         }
+
+        if (earliest.time < 0.0) {
+            start.x += motion.x;
+            start.y += motion.y;
+            break;
+        }
+
+        start.x += motion.x * earliest.time;
+        start.y += motion.y * earliest.time;
+
+        //slide: what is left of the motion keeps going along the face
+        double remaining = 1.0 - earliest.time;
+        if (earliest.normal.x != 0.0) {
+            movement.speed.x = 0.0;
+            motion.x = 0.0;
+        }
+        else {
+            movement.speed.y = 0.0;
+            motion.y = 0.0;
+            if (earliest.normal.y < 0.0) position.is_grounded = true;
+        }
+        motion.x *= remaining;
+        motion.y *= remaining;
+
+        if (earliest.id == id) {
+            tile_damage = std::max(tile_damage, earliest.damage);
+        }
+        else {
+            swept_pairs.emplace_back(std::min(id, earliest.id), std::max(id, earliest.id));
+            resolve_health_damage(id, earliest.id);
+            resolve_health_damage(earliest.id, id);
+        }
+    }
+
+    position.pos = start;
+    collision.hitbox.x = static_cast<float>(start.x);
+    collision.hitbox.y = static_cast<float>(start.y);
+    return tile_damage;
+}
+
+//pushes the body out of the shallowest solid tile face it overlaps, false if it overlaps none.
+//faces shared by two solid tiles are skipped, so bodies slide along rows of tiles without catching on the seams
+bool Collision_System::push_out_of_tiles(components::position& position, components::movement& movement, components::collision& collision) {
+    int first_column, first_row, last_column, last_row;
+    if (!tilemap->cell_range(collision.hitbox, first_column, first_row, last_column, last_row)) return false;
+
+    const SDL_FRect& box = collision.hitbox;
+    collision_direction best = collision_direction::NO_COLLISION;
+    float best_depth = 0.0f;
+
+    auto consider = [&](collision_direction direction, float depth) {
+        if (depth > 0.0f && (best == collision_direction::NO_COLLISION || depth < best_depth)) {
+            best = direction;
+            best_depth = depth;
+        }
+    };
+
+    for (int row = first_row; row <= last_row; ++row) {
+        for (int column = first_column; column <= last_column; ++column) {
+            if (!tilemap->solid(column, row)) continue;
+
+            SDL_FRect cell = tilemap->cell_rect(column, row);
+            if (!tilemap->solid(column, row - 1)) consider(collision_direction::BOTTOM_COLLISION, box.y + box.h - cell.y);
+            if (!tilemap->solid(column, row + 1)) consider(collision_direction::TOP_COLLISION, cell.y + cell.h - box.y);
+            if (!tilemap->solid(column - 1, row)) consider(collision_direction::LEFT_COLLISION, box.x + box.w - cell.x);
+            if (!tilemap->solid(column + 1, row)) consider(collision_direction::RIGHT_COLLISION, cell.x + cell.w - box.x);
+        }
+    }
+
+    //same response as a rigid entity: stop along the axis and move out
+    switch (best) {
+    case collision_direction::BOTTOM_COLLISION:
+        position.is_grounded = true;
+        movement.speed.y = 0.0;
+        position.pos.y -= best_depth;
+        break;
+    case collision_direction::TOP_COLLISION:
+        movement.speed.y = 0.0;
+        position.pos.y += best_depth;
+        break;
+    case collision_direction::LEFT_COLLISION:
+        movement.speed.x = 0.0;
+        position.pos.x -= best_depth;
+        break;
+    case collision_direction::RIGHT_COLLISION:
+        movement.speed.x = 0.0;
+        position.pos.x += best_depth;
+        break;
+    default:
+        return false;
+    }
+
+    collision.hitbox.x = static_cast<float>(position.pos.x);
+    collision.hitbox.y = static_cast<float>(position.pos.y);
+    return true;
+}
+
+//most contacts don't overlap (the broadphase pairs swept boxes, the static tier fat ones), so they are
+//tested in a batch first and only the overlapping ones go through detect_collision
+void Collision_System::process_contacts() {
+    static_assert(static_cast<int>(TOP_COLLISION) == CONTACT_TOP && static_cast<int>(BOTTOM_COLLISION) == CONTACT_BOTTOM &&
+        static_cast<int>(LEFT_COLLISION) == CONTACT_LEFT && static_cast<int>(RIGHT_COLLISION) == CONTACT_RIGHT, "contact directions must match");
+
+    contact_boxes.resize(contacts.size());
+    for (size_t i = 0; i < contacts.size(); ++i) {
+        contact_boxes.set(i, em.get_component<components::collision>(contacts[i].first)->hitbox,
+            em.get_component<components::collision>(contacts[i].second)->hitbox);
+    }
+
+    contact_directions.resize(contacts.size());
+    overlap_directions(contact_boxes, contact_directions.data(), settings.narrowphase);
+
+    //bodies pushed by a resolution in this pass are stamped with it, so rejected pairs never look their hitboxes up again
+    if (++contact_pass == 0) {
+        std::fill(resolved_pass.begin(), resolved_pass.end(), 0);
+        contact_pass = 1;
+    }
+
+    for (size_t i = 0; i < contacts.size(); ++i) {
+        entity_handle first = contacts[i].first;
+        entity_handle second = contacts[i].second;
+
+        //resolving an earlier pair can push a body into this one, the batch result only holds if neither moved since
+        if (contact_directions[i] == CONTACT_NONE &&
+            !moved_since_batch(first, contact_boxes.ax[i], contact_boxes.ay[i], contact_boxes.aw[i], contact_boxes.ah[i]) &&
+            !moved_since_batch(second, contact_boxes.bx[i], contact_boxes.by[i], contact_boxes.bw[i], contact_boxes.bh[i])) {
+            continue;
+        }
+
+        process_pair(first, second);
     }
 }
 
-Collision_System::collision_direction Collision_System::detect_collision(entity& e1, entity& e2) {
+void Collision_System::mark_resolved(entity_handle id, const SDL_FRect& hitbox) {
+    if (id.index >= resolved_pass.size()) {
+        resolved_pass.resize(id.index + 1, 0);
+        resolved_boxes.resize(id.index + 1);
+    }
+    resolved_pass[id.index] = contact_pass;
+    resolved_boxes[id.index] = hitbox;
+}
+
+bool Collision_System::moved_since_batch(entity_handle id, float x, float y, float w, float h) const {
+    if (id.index >= resolved_pass.size() || resolved_pass[id.index] != contact_pass) return false;
+
+    const SDL_FRect& hitbox = resolved_boxes[id.index];
+    return hitbox.x != x || hitbox.y != y || hitbox.w != w || hitbox.h != h;
+}
+
+void Collision_System::process_pair(entity_handle first, entity_handle second) {
+    //the moving body is resolved first so it is the one pushed out and grounded
+    if (!em.has_component<components::movement>(first) && em.has_component<components::movement>(second)) {
+        std::swap(first, second);
+    }
+
+    entity_handle e1 = first;
+    entity_handle e2 = second;
+
+    collision_direction direction = detect_collision(e1, e2);
+    if (direction == collision_direction::NO_COLLISION) return;
+
+    resolve_collision(e1, e2, direction);
+
+    //each body still gets resolved from its own side if they keep overlapping (damage goes both ways)
+    direction = detect_collision(e2, e1);
+    if (direction != collision_direction::NO_COLLISION) {
+        resolve_collision(e2, e1, direction);
+    }
+}
+
+types::Vec2<double> Collision_System::step_motion(entity_handle id) {
+    if (!em.has_component<components::movement>(id)) return { 0.0, 0.0 };
+
+    auto* position = em.get_component<components::position>(id);
+    if (!position) return { 0.0, 0.0 };
+    return { position->pos.x - position->previous_pos.x, position->pos.y - position->previous_pos.y };
+}
+
+Collision_System::collision_direction Collision_System::detect_collision(entity_handle e1, entity_handle e2) {
 
     collision_direction direction = collision_direction::NO_COLLISION;
 
-    auto* collision_component_1 = em.get_component<components::collision>(e1.id);
-    auto* collision_component_2 = em.get_component<components::collision>(e2.id);
+    auto* collision_component_1 = em.get_component<components::collision>(e1);
+    auto* collision_component_2 = em.get_component<components::collision>(e2);
 
     if (!collision_component_1 || !collision_component_2) {
         return collision_direction::NO_COLLISION;
@@ -105,13 +711,26 @@ Collision_System::collision_direction Collision_System::detect_collision(entity&
         return collision_direction::NO_COLLISION;
     }
 
-    // Calculate overlap amounts
+    //the face the bodies met through, found by sweeping their boxes from where they were before the step
+    types::Vec2<double> motion_1 = step_motion(e1);
+    types::Vec2<double> motion_2 = step_motion(e2);
+    SDL_FRect start_2{ static_cast<float>(hitbox_2.x - motion_2.x), static_cast<float>(hitbox_2.y - motion_2.y), hitbox_2.w, hitbox_2.h };
+
+    sweep_hit hit;
+    if (sweep_box({ hitbox_1.x - motion_1.x, hitbox_1.y - motion_1.y }, hitbox_1.w, hitbox_1.h,
+        { motion_1.x - motion_2.x, motion_1.y - motion_2.y }, start_2, hit)) {
+        if (hit.normal.x < 0.0) return collision_direction::LEFT_COLLISION;
+        if (hit.normal.x > 0.0) return collision_direction::RIGHT_COLLISION;
+        if (hit.normal.y < 0.0) return collision_direction::BOTTOM_COLLISION;
+        return collision_direction::TOP_COLLISION;
+    }
+
+    //bodies already overlapping before the step are separated along the axis of least overlap
     float overlapLeft = hitbox_1.x + hitbox_1.w - hitbox_2.x;
     float overlapRight = hitbox_2.x + hitbox_2.w - hitbox_1.x;
     float overlapBottom = hitbox_1.y + hitbox_1.h - hitbox_2.y;
     float overlapTop = hitbox_2.y + hitbox_2.h - hitbox_1.y;
 
-    // Default to the smallest overlap if no movement direction is dominant
     float minOverlap = std::min({ overlapLeft, overlapRight, overlapTop, overlapBottom });
 
     if (minOverlap == overlapTop) {
@@ -127,15 +746,13 @@ Collision_System::collision_direction Collision_System::detect_collision(entity&
         direction = collision_direction::RIGHT_COLLISION;
     }
 
-    resolve_collision(e1, e2, direction);
-
     return direction;
 }
 
-void Collision_System::resolve_collision(entity& e1, entity& e2, collision_direction direction) {
+void Collision_System::resolve_collision(entity_handle e1, entity_handle e2, collision_direction direction) {
 
-    auto* e1_collision = em.get_component<components::collision>(e1.id);
-    auto* e2_collision = em.get_component<components::collision>(e2.id);
+    auto* e1_collision = em.get_component<components::collision>(e1);
+    auto* e2_collision = em.get_component<components::collision>(e2);
 
     //resolve rigid body collisions
     if (e1_collision->is_rigid || e2_collision->is_rigid) {
@@ -146,18 +763,18 @@ void Collision_System::resolve_collision(entity& e1, entity& e2, collision_direc
     resolve_health_damage(e1, e2);
 }
 
-void Collision_System::resolve_rigid_collision(entity& e1, entity& e2, collision_direction direction) {
-    auto* e1_movement = em.get_component<components::movement>(e1.id);
-    auto* e2_movement = em.get_component<components::movement>(e2.id);
+void Collision_System::resolve_rigid_collision(entity_handle e1, entity_handle e2, collision_direction direction) {
+    auto* e1_movement = em.get_component<components::movement>(e1);
+    auto* e2_movement = em.get_component<components::movement>(e2);
 
     // Ensure neither entity is moved if it does not have a movement component
     if (!e1_movement && !e2_movement) return;
 
-    auto* e1_position = em.get_component<components::position>(e1.id);
-    auto* e2_position = em.get_component<components::position>(e2.id);
+    auto* e1_position = em.get_component<components::position>(e1);
+    auto* e2_position = em.get_component<components::position>(e2);
 
-    auto& e1_hitbox = em.get_component<components::collision>(e1.id)->hitbox;
-    auto& e2_hitbox = em.get_component<components::collision>(e2.id)->hitbox;
+    auto& e1_hitbox = em.get_component<components::collision>(e1)->hitbox;
+    auto& e2_hitbox = em.get_component<components::collision>(e2)->hitbox;
 
     float x = 0;
 
@@ -205,23 +822,19 @@ void Collision_System::resolve_rigid_collision(entity& e1, entity& e2, collision
     if (e1_position) {
         e1_hitbox.x = e1_position->pos.x;
         e1_hitbox.y = e1_position->pos.y;
+        mark_resolved(e1, e1_hitbox);
     }
     if (e2_position && e2_movement) {
         e2_hitbox.x = e2_position->pos.x;
         e2_hitbox.y = e2_position->pos.y;
+        mark_resolved(e2, e2_hitbox);
     }
 }
 
-void Collision_System::resolve_health_damage(entity& e1, entity& e2) {
+void Collision_System::resolve_health_damage(entity_handle e1, entity_handle e2) {
 
-    if (e1.mask.test(components::get_id<components::health>()) &&
-        e2.mask.test(components::get_id<components::damage>())) {
-        auto* e1_health = em.get_component<components::health>(e1.id);
-        auto* e2_damage = em.get_component<components::damage>(e2.id);
-
-        em.assign_component<components::pending_damage>(e1.id);
-        auto* pending_damage = em.get_component<components::pending_damage>(e1.id);
-
-        pending_damage->pending_amount += e2_damage->damage_amount;
+    if (em.has_component<components::health>(e1) && em.has_component<components::damage>(e2)) {
+        auto* e2_damage = em.get_component<components::damage>(e2);
+        damage_events.send(damage_event{ e1, e2, e2_damage->damage_amount });
     }
-}
\ No newline at end of file
+}
@@ -2,33 +2,137 @@
 #include <SDL3/SDL.h>
 #include <iostream>
 #include <cmath>
+#include <limits>
 #include <algorithm>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "broadphase.h"
+#include "bvh.h"
 #include "input.h"
+#include "integration.h"
 #include "entity.h"
+#include "job_system.h"
+#include "tilemap.h"
+
+#define SPEED_TIME_UNIT (1.0 / 60.0) //speeds are in pixels per 1/60 s, the frame time the game was tuned at
+#define TILE_RESOLVE_PASSES 4 //faces a body can be pushed out of per update, a corner takes two
+#define CCD_ITERATIONS 3 //faces a swept body can hit and slide along in a single step
 
 class Collision_System;
 
+//first contact of a swept box
+struct sweep_hit {
+    double time = -1.0; //fraction of the motion done at the contact, negative without one
+    types::Vec2<double> normal; //of the face hit, pointing away from it
+    entity_handle id;
+    int damage = 0;
+};
+
+bool sweep_box(types::Vec2<double> start, double w, double h, types::Vec2<double> motion, const SDL_FRect& target, sweep_hit& hit);
+
 class Collision_System {
 public:
     enum collision_direction { NO_COLLISION, TOP_COLLISION, BOTTOM_COLLISION, LEFT_COLLISION, RIGHT_COLLISION };
 
-	Collision_System(entity_manager&);
-	collision_direction detect_collision(entity&, entity&);
-	void resolve_collision(entity&, entity&, collision_direction);
-	void resolve_rigid_collision(entity&, entity&, collision_direction);
-	void resolve_health_damage(entity&, entity&);
+	//sets the collision component hooks
+	Collision_System(entity_manager&, broadphase_settings settings = broadphase_settings());
+	~Collision_System();
+
+	static system_access access();
+
+	//finds the candidate pairs of every entity with a collision component and resolves the ones that overlap,
+	//must run after Movement_System::update so the hitboxes are in their final position
+	void update();
+
+	//builds the static tier out of every collision entity without a movement component.
+	//has to be called again whenever level geometry is added or moved, removing it rebuilds the tier on its own
+	void build_static_tier();
+
+	collision_direction detect_collision(entity_handle, entity_handle);
+	void resolve_collision(entity_handle, entity_handle, collision_direction);
+	void resolve_rigid_collision(entity_handle, entity_handle, collision_direction);
+	void resolve_health_damage(entity_handle, entity_handle);
+
+	//static geometry kept as tiles instead of entities, resolved against every awake dynamic body
+	//before the entity pairs. the map has to outlive the system, nullptr removes it
+	void set_tilemap(const Tilemap* map) {
+		tilemap = map;
+	}
+
+	//pairs produced by the last broadphase pass, each unordered pair appears once
+	const std::vector<body_pair>& candidate_pairs() const {
+		return broadphase->candidate_pairs();
+	}
+
+	Broadphase& get_broadphase() {
+		return *broadphase;
+	}
 
 private:
+	//collision on_remove hook, the context is the Collision_System
+	static void remove_body(void* context, entity_manager& em, entity_handle id);
+
+	void process_contacts();
+	void process_pair(entity_handle, entity_handle);
+	void mark_resolved(entity_handle, const SDL_FRect&);
+	bool moved_since_batch(entity_handle, float x, float y, float w, float h) const;
+	types::Vec2<double> step_motion(entity_handle);
+	void sweep_bodies();
+	int sweep(entity_handle, components::position&, components::movement&, components::collision&);
+	bool push_out_of_tiles(components::position&, components::movement&, components::collision&);
+	bool wake_on_contact(entity_handle, entity_handle);
+	void wake_unsupported();
+	void wake(entity_handle);
+	void update_sleep();
+
     entity_manager& em;
+	event_queue<damage_event>& damage_events; //damaging contacts, the health system applies them next step
+	broadphase_settings settings;
+	std::unique_ptr<Broadphase> broadphase; //dynamic bodies only, sleeping ones included so they can be woken up
+	Static_BVH static_tier;
+	bool static_tier_built = false;
+	std::vector<broadphase_body> removed_bodies; //collision bodies removed since the last update
+	Static_BVH removed_tier; //removed_bodies while the sleepers touching them are looked up
+	const Tilemap* tilemap = nullptr;
+
+	std::vector<broadphase_body> bodies; //hitboxes gathered for the broadphase every update
+	std::vector<body_pair> contacts; //pairs handed to the narrowphase this update
+	pair_batch contact_boxes; //hitboxes of the contacts, in the same order
+	std::vector<std::uint8_t> contact_directions; //overlap test result of every contact
+	std::vector<std::uint32_t> resolved_pass; //per entity slot, last contact pass a resolution wrote its hitbox in
+	std::vector<SDL_FRect> resolved_boxes; //per entity slot, the hitbox that resolution wrote
+	std::uint32_t contact_pass = 0;
+	std::vector<body_pair> swept_pairs; //(dynamic, static) contacts already resolved by the sweep this update
+	std::vector<broadphase_body> sweep_candidates; //rigid static bodies along the path of the body being swept
 };
 
 class Movement_System {
 public:
-	Movement_System(entity_manager& em, Input_Handler& input, Collision_System& collision_sys);
+	//entities are integrated in parallel ranges when a thread pool is given
+	Movement_System(entity_manager& em, Input_Handler& input, Collision_System& collision_sys, Thread_Pool* pool = nullptr);
+
+	static system_access access();
 
 	void update(double);
 
+	//bodies without input are integrated in batches with `isa`, or in place over the columns in archetype storage.
+	//disabled, every body goes through integrate() one at a time. the batches are memory bound, the scalar
+	//version measured faster than SSE and AVX2 (integration_bench) so it is the default
+	void set_bulk_integration(bool enabled, simd_isa isa = simd_isa::SCALAR) {
+		bulk_enabled = enabled;
+		bulk_isa = isa;
+	}
+
 private:
+	//integrates a single entity, optional components are nullptr when the entity doesn't have them
+	void integrate(double, components::position*, components::movement*,
+		components::gravity*, components::input*, components::jump*, components::collision*);
+
 	entity_manager& em;
 	Input_Handler& input;
+	Thread_Pool* pool;
+	std::vector<chunk_view> chunks; //archetype chunks gathered for the parallel loop
+	bool bulk_enabled = true;
+	simd_isa bulk_isa = simd_isa::SCALAR;
 };
@@ -0,0 +1,146 @@
+#include "narrowphase.h"
+#include <algorithm>
+
+void pair_batch::clear() {
+    ax.clear(); ay.clear(); aw.clear(); ah.clear();
+    bx.clear(); by.clear(); bw.clear(); bh.clear();
+}
+
+void pair_batch::push(const SDL_FRect& a, const SDL_FRect& b) {
+    ax.push_back(a.x); ay.push_back(a.y); aw.push_back(a.w); ah.push_back(a.h);
+    bx.push_back(b.x); by.push_back(b.y); bw.push_back(b.w); bh.push_back(b.h);
+}
+
+void pair_batch::resize(size_t count) {
+    ax.resize(count); ay.resize(count); aw.resize(count); ah.resize(count);
+    bx.resize(count); by.resize(count); bw.resize(count); bh.resize(count);
+}
+
+namespace {
+    //the reference version, the SIMD ones have to give exactly the same answers
+    void overlap_scalar(const pair_batch& batch, size_t begin, size_t end, std::uint8_t* out) {
+        for (size_t i = begin; i < end; ++i) {
+            float a_right = batch.ax[i] + batch.aw[i];
+            float a_bottom = batch.ay[i] + batch.ah[i];
+            float b_right = batch.bx[i] + batch.bw[i];
+            float b_bottom = batch.by[i] + batch.bh[i];
+
+            if (a_right <= batch.bx[i] || b_right <= batch.ax[i] || a_bottom <= batch.by[i] || b_bottom <= batch.ay[i]) {
+                out[i] = CONTACT_NONE;
+                continue;
+            }
+
+            float left = a_right - batch.bx[i];
+            float right = b_right - batch.ax[i];
+            float bottom = a_bottom - batch.by[i];
+            float top = b_bottom - batch.ay[i];
+            float least = std::min({ left, right, top, bottom });
+
+            //ties go to top, bottom, left, right in that order, like detect_collision
+            if (least == top) out[i] = CONTACT_TOP;
+            else if (least == bottom) out[i] = CONTACT_BOTTOM;
+            else if (least == left) out[i] = CONTACT_LEFT;
+            else out[i] = CONTACT_RIGHT;
+        }
+    }
+
+#if SIMD_X86
+    //sse2 has no blend, lanes of `mask` pick `a`, the rest keep `b`
+    inline __m128i select_sse(__m128 mask, __m128i a, __m128i b) {
+        __m128i bits = _mm_castps_si128(mask);
+        return _mm_or_si128(_mm_and_si128(bits, a), _mm_andnot_si128(bits, b));
+    }
+
+    size_t overlap_sse(const pair_batch& batch, size_t count, std::uint8_t* out) {
+        size_t i = 0;
+        alignas(16) std::int32_t directions[4];
+
+        for (; i + 4 <= count; i += 4) {
+            __m128 ax = _mm_loadu_ps(&batch.ax[i]);
+            __m128 ay = _mm_loadu_ps(&batch.ay[i]);
+            __m128 bx = _mm_loadu_ps(&batch.bx[i]);
+            __m128 by = _mm_loadu_ps(&batch.by[i]);
+            __m128 a_right = _mm_add_ps(ax, _mm_loadu_ps(&batch.aw[i]));
+            __m128 a_bottom = _mm_add_ps(ay, _mm_loadu_ps(&batch.ah[i]));
+            __m128 b_right = _mm_add_ps(bx, _mm_loadu_ps(&batch.bw[i]));
+            __m128 b_bottom = _mm_add_ps(by, _mm_loadu_ps(&batch.bh[i]));
+
+            __m128 separated = _mm_or_ps(_mm_or_ps(_mm_cmple_ps(a_right, bx), _mm_cmple_ps(b_right, ax)),
+                _mm_or_ps(_mm_cmple_ps(a_bottom, by), _mm_cmple_ps(b_bottom, ay)));
+
+            __m128 left = _mm_sub_ps(a_right, bx);
+            __m128 right = _mm_sub_ps(b_right, ax);
+            __m128 bottom = _mm_sub_ps(a_bottom, by);
+            __m128 top = _mm_sub_ps(b_bottom, ay);
+            __m128 least = _mm_min_ps(_mm_min_ps(left, right), _mm_min_ps(top, bottom));
+
+            //lowest priority first, every later match overwrites it
+            __m128i direction = _mm_set1_epi32(CONTACT_RIGHT);
+            direction = select_sse(_mm_cmpeq_ps(least, left), _mm_set1_epi32(CONTACT_LEFT), direction);
+            direction = select_sse(_mm_cmpeq_ps(least, bottom), _mm_set1_epi32(CONTACT_BOTTOM), direction);
+            direction = select_sse(_mm_cmpeq_ps(least, top), _mm_set1_epi32(CONTACT_TOP), direction);
+            direction = _mm_andnot_si128(_mm_castps_si128(separated), direction);
+
+            _mm_store_si128(reinterpret_cast<__m128i*>(directions), direction);
+            for (int lane = 0; lane < 4; ++lane) {
+                out[i + lane] = static_cast<std::uint8_t>(directions[lane]);
+            }
+        }
+        return i;
+    }
+
+    SIMD_AVX2_TARGET size_t overlap_avx2(const pair_batch& batch, size_t count, std::uint8_t* out) {
+        size_t i = 0;
+        alignas(32) std::int32_t directions[8];
+
+        for (; i + 8 <= count; i += 8) {
+            __m256 ax = _mm256_loadu_ps(&batch.ax[i]);
+            __m256 ay = _mm256_loadu_ps(&batch.ay[i]);
+            __m256 bx = _mm256_loadu_ps(&batch.bx[i]);
+            __m256 by = _mm256_loadu_ps(&batch.by[i]);
+            __m256 a_right = _mm256_add_ps(ax, _mm256_loadu_ps(&batch.aw[i]));
+            __m256 a_bottom = _mm256_add_ps(ay, _mm256_loadu_ps(&batch.ah[i]));
+            __m256 b_right = _mm256_add_ps(bx, _mm256_loadu_ps(&batch.bw[i]));
+            __m256 b_bottom = _mm256_add_ps(by, _mm256_loadu_ps(&batch.bh[i]));
+
+            __m256 separated = _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(a_right, bx, _CMP_LE_OQ), _mm256_cmp_ps(b_right, ax, _CMP_LE_OQ)),
+                _mm256_or_ps(_mm256_cmp_ps(a_bottom, by, _CMP_LE_OQ), _mm256_cmp_ps(b_bottom, ay, _CMP_LE_OQ)));
+
+            __m256 left = _mm256_sub_ps(a_right, bx);
+            __m256 right = _mm256_sub_ps(b_right, ax);
+            __m256 bottom = _mm256_sub_ps(a_bottom, by);
+            __m256 top = _mm256_sub_ps(b_bottom, ay);
+            __m256 least = _mm256_min_ps(_mm256_min_ps(left, right), _mm256_min_ps(top, bottom));
+
+            __m256 direction = _mm256_castsi256_ps(_mm256_set1_epi32(CONTACT_RIGHT));
+            direction = _mm256_blendv_ps(direction, _mm256_castsi256_ps(_mm256_set1_epi32(CONTACT_LEFT)), _mm256_cmp_ps(least, left, _CMP_EQ_OQ));
+            direction = _mm256_blendv_ps(direction, _mm256_castsi256_ps(_mm256_set1_epi32(CONTACT_BOTTOM)), _mm256_cmp_ps(least, bottom, _CMP_EQ_OQ));
+            direction = _mm256_blendv_ps(direction, _mm256_castsi256_ps(_mm256_set1_epi32(CONTACT_TOP)), _mm256_cmp_ps(least, top, _CMP_EQ_OQ));
+            direction = _mm256_andnot_ps(separated, direction);
+
+            _mm256_store_si256(reinterpret_cast<__m256i*>(directions), _mm256_castps_si256(direction));
+            for (int lane = 0; lane < 8; ++lane) {
+                out[i + lane] = static_cast<std::uint8_t>(directions[lane]);
+            }
+        }
+        return i;
+    }
+#endif
+}
+
+void overlap_directions(const pair_batch& batch, std::uint8_t* out, simd_isa isa) {
+    size_t count = batch.size();
+    size_t done = 0;
+
+#if SIMD_X86
+    isa = supported_simd_isa(isa);
+
+    //the pairs left over past the last full vector go through the scalar version
+    if (isa == simd_isa::AVX2) done = overlap_avx2(batch, count, out);
+    else if (isa == simd_isa::SSE) done = overlap_sse(batch, count, out);
+#else
+    (void)isa;
+#endif
+
+    overlap_scalar(batch, done, count, out);
+}
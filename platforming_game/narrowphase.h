@@ -0,0 +1,40 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <cstdint>
+#include <vector>
+#include "simd.h"
+
+//side of the first box that touches the second one, same values as Collision_System::collision_direction
+enum contact_direction : std::uint8_t {
+    CONTACT_NONE,
+    CONTACT_TOP,
+    CONTACT_BOTTOM,
+    CONTACT_LEFT,
+    CONTACT_RIGHT
+};
+
+//hitboxes of candidate pairs as structure of arrays, the layout the SIMD kernels load from
+struct pair_batch {
+    std::vector<float> ax, ay, aw, ah;
+    std::vector<float> bx, by, bw, bh;
+
+    void clear();
+    void push(const SDL_FRect& a, const SDL_FRect& b);
+
+    //filling a batch of known size through set() skips the capacity checks of push()
+    void resize(size_t count);
+
+    void set(size_t i, const SDL_FRect& a, const SDL_FRect& b) {
+        ax[i] = a.x; ay[i] = a.y; aw[i] = a.w; ah[i] = a.h;
+        bx[i] = b.x; by[i] = b.y; bw[i] = b.w; bh[i] = b.h;
+    }
+
+    size_t size() const {
+        return ax.size();
+    }
+};
+
+//for every pair of the batch, CONTACT_NONE if the boxes don't overlap (touching isn't overlapping),
+//otherwise the side of least overlap like detect_collision falls back to. `out` holds batch.size() entries.
+//SSE tests 4 pairs at a time, AVX2 8
+void overlap_directions(const pair_batch& batch, std::uint8_t* out, simd_isa isa = best_simd_isa());
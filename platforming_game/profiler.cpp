@@ -0,0 +1,146 @@
+#include "profiler.h"
+#include <algorithm>
+#include <cstdio>
+
+std::atomic<bool> Profiler::active{ false };
+
+namespace {
+    thread_local profile_ring* ring = nullptr;
+}
+
+Profiler& Profiler::get() {
+    static Profiler profiler;
+    return profiler;
+}
+
+std::uint32_t Profiler::marker(const std::string& name) {
+    std::lock_guard<std::mutex> guard(lock);
+    for (size_t i = 0; i < markers.size(); ++i) {
+        if (markers[i].name == name) return static_cast<std::uint32_t>(i);
+    }
+
+    markers.emplace_back();
+    markers.back().name = name;
+    return static_cast<std::uint32_t>(markers.size() - 1);
+}
+
+profile_ring& Profiler::thread_ring() {
+    if (!ring) {
+        std::lock_guard<std::mutex> guard(lock);
+        rings.push_back(std::make_unique<profile_ring>());
+        ring = rings.back().get();
+    }
+    return *ring;
+}
+
+void Profiler::record(std::uint32_t marker, Uint64 start, Uint64 end) {
+    if (!thread_ring().push(profile_event{ marker, start, end })) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Profiler::end_frame() {
+    const double ms_per_tick = 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+    bool capturing = current_frame >= capture_first && current_frame <= capture_last;
+
+    std::lock_guard<std::mutex> guard(lock);
+    for (std::uint32_t thread = 0; thread < rings.size(); ++thread) {
+        rings[thread]->drain([&](const profile_event& event) {
+            marker_history& history = markers[event.marker];
+            history.current_ms += static_cast<double>(event.end - event.start) * ms_per_tick;
+            history.current_calls++;
+
+            if (capturing) {
+                captured.push_back(captured_event{ event, thread, current_frame });
+            }
+        });
+    }
+
+    //markers not hit this frame count as 0 ms, so a system that stopped running drops out of the averages
+    for (auto& history : markers) {
+        history.frame_ms[history.frames % PROFILER_HISTORY] = history.current_ms;
+        history.frames++;
+        history.last_ms = history.current_ms;
+        history.last_calls = history.current_calls;
+        history.current_ms = 0.0;
+        history.current_calls = 0;
+    }
+
+    ++current_frame;
+}
+
+std::vector<profile_stats> Profiler::stats() const {
+    std::vector<profile_stats> result;
+    double samples[PROFILER_HISTORY];
+
+    std::lock_guard<std::mutex> guard(lock);
+    for (auto& history : markers) {
+        size_t count = std::min<size_t>(history.frames, PROFILER_HISTORY);
+        if (count == 0) continue;
+
+        std::copy(history.frame_ms, history.frame_ms + count, samples);
+        std::sort(samples, samples + count);
+
+        double sum = 0.0;
+        for (size_t i = 0; i < count; ++i) {
+            sum += samples[i];
+        }
+        if (sum == 0.0) continue;
+
+        profile_stats marker_stats;
+        marker_stats.name = history.name;
+        marker_stats.min_ms = samples[0];
+        marker_stats.avg_ms = sum / static_cast<double>(count);
+        marker_stats.p99_ms = samples[(count * 99 + 99) / 100 - 1];
+        marker_stats.last_ms = history.last_ms;
+        marker_stats.calls = history.last_calls;
+        result.push_back(std::move(marker_stats));
+    }
+
+    std::sort(result.begin(), result.end(), [](const profile_stats& a, const profile_stats& b) { return a.name < b.name; });
+    return result;
+}
+
+void Profiler::capture(unsigned long long first_frame, unsigned long long last_frame) {
+    std::lock_guard<std::mutex> guard(lock);
+    capture_first = first_frame;
+    capture_last = last_frame;
+    captured.clear();
+}
+
+bool Profiler::write_chrome_trace(const std::string& path) const {
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) return false;
+
+    const double us_per_tick = 1000000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    //timestamps start at the earliest captured event
+    Uint64 origin = captured.empty() ? 0 : captured.front().event.start;
+    for (auto& captured_one : captured) {
+        origin = std::min(origin, captured_one.event.start);
+    }
+
+    std::fprintf(file, "{\"traceEvents\":[\n");
+
+    bool first = true;
+    for (std::uint32_t thread = 0; thread < rings.size(); ++thread) {
+        std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}",
+            first ? "" : ",\n", thread, thread);
+        first = false;
+    }
+
+    //marker names come from string literals and system names, none of them need escaping
+    for (auto& captured_one : captured) {
+        const profile_event& event = captured_one.event;
+        double start = static_cast<double>(event.start - origin) * us_per_tick;
+        double duration = static_cast<double>(event.end - event.start) * us_per_tick;
+        std::fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"frame\":%llu}}",
+            first ? "" : ",\n", markers[event.marker].name.c_str(), start, duration, captured_one.thread, captured_one.frame);
+        first = false;
+    }
+
+    std::fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    return std::fclose(file) == 0;
+}
@@ -0,0 +1,152 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "spsc_ring.h"
+
+//PROFILING 0 compiles every PROFILE_SCOPE out, with it on the markers only cost a relaxed load while
+//the profiler is disabled
+#ifndef PROFILING
+#define PROFILING 1
+#endif
+
+#define PROFILER_RING_SIZE 16384 //events buffered per thread between two end_frame calls, a power of two
+#define PROFILER_HISTORY 240 //frames the min/avg/p99 of every marker are computed over
+
+//one timed scope, in performance counter ticks
+struct profile_event {
+    std::uint32_t marker;
+    Uint64 start;
+    Uint64 end;
+};
+
+//time spent in a marker per frame over the last PROFILER_HISTORY frames, in milliseconds.
+//a marker hit several times in a frame (or on several threads) counts the sum of them
+struct profile_stats {
+    std::string name;
+    double min_ms = 0.0;
+    double avg_ms = 0.0;
+    double p99_ms = 0.0;
+    double last_ms = 0.0; //last frame
+    size_t calls = 0; //in the last frame
+};
+
+using profile_ring = spsc_ring<profile_event, PROFILER_RING_SIZE>; //written by its thread, drained by end_frame
+
+//frame profiler fed by PROFILE_SCOPE markers. every thread records into its own ring without locking,
+//end_frame (called by the thread driving the frames, once the frame's jobs are done) collects them into
+//per marker history and, inside the capture range, into the events written by write_chrome_trace
+class Profiler {
+public:
+    static Profiler& get();
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    //recording starts disabled, markers hit while disabled record nothing
+    void set_enabled(bool enabled) {
+        active.store(enabled, std::memory_order_relaxed);
+    }
+
+    static bool enabled() {
+        return active.load(std::memory_order_relaxed);
+    }
+
+    //id of a marker name, the same name always gets the same id
+    std::uint32_t marker(const std::string& name);
+
+    void record(std::uint32_t marker, Uint64 start, Uint64 end);
+
+    //closes the current frame: every event recorded since the previous call belongs to it
+    void end_frame();
+
+    //number of the frame being recorded, the first one is 0
+    unsigned long long frame() const {
+        return current_frame;
+    }
+
+    //markers hit at least once, sorted by name
+    std::vector<profile_stats> stats() const;
+
+    //keeps the events of frames [first_frame, last_frame] for write_chrome_trace, dropping the ones kept before
+    void capture(unsigned long long first_frame, unsigned long long last_frame);
+
+    //writes the captured events in the chrome trace event format (chrome://tracing, perfetto)
+    bool write_chrome_trace(const std::string& path) const;
+
+    //events lost because a ring was full
+    size_t dropped_events() const {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    Profiler() = default;
+
+    struct marker_history {
+        std::string name;
+        double frame_ms[PROFILER_HISTORY] = {};
+        size_t frames = 0; //frames recorded, capped at PROFILER_HISTORY
+        double current_ms = 0.0; //sum of the frame being collected
+        size_t current_calls = 0;
+        double last_ms = 0.0;
+        size_t last_calls = 0;
+    };
+
+    struct captured_event {
+        profile_event event;
+        std::uint32_t thread;
+        unsigned long long frame;
+    };
+
+    profile_ring& thread_ring();
+
+    static std::atomic<bool> active;
+
+    mutable std::mutex lock; //guards markers and rings, never taken while recording
+    std::vector<marker_history> markers;
+    std::vector<std::unique_ptr<profile_ring>> rings; //one per thread that recorded, kept for the whole run
+    std::atomic<size_t> dropped{ 0 };
+
+    unsigned long long current_frame = 0;
+    unsigned long long capture_first = 1;
+    unsigned long long capture_last = 0; //empty range, nothing is captured
+    std::vector<captured_event> captured;
+};
+
+//times the scope it lives in
+class profile_scope {
+public:
+    explicit profile_scope(std::uint32_t marker) : marker(marker), start(Profiler::enabled() ? SDL_GetPerformanceCounter() : 0) {}
+
+    ~profile_scope() {
+        if (start != 0) {
+            Profiler::get().record(marker, start, SDL_GetPerformanceCounter());
+        }
+    }
+
+    profile_scope(const profile_scope&) = delete;
+    profile_scope& operator=(const profile_scope&) = delete;
+
+private:
+    std::uint32_t marker;
+    Uint64 start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+//PROFILE_SCOPE("name") times the rest of the enclosing scope under `name`, PROFILE_MARKER_SCOPE(id)
+//does the same with an id from Profiler::marker, for names only known at runtime
+#if PROFILING
+#define PROFILE_MARKER_SCOPE(marker) profile_scope PROFILE_CONCAT(profile_scope_, __LINE__)(marker)
+#define PROFILE_SCOPE(name) \
+    static const std::uint32_t PROFILE_CONCAT(profile_marker_, __LINE__) = Profiler::get().marker(name); \
+    PROFILE_MARKER_SCOPE(PROFILE_CONCAT(profile_marker_, __LINE__))
+#else
+#define PROFILE_MARKER_SCOPE(marker) ((void)0)
+#define PROFILE_SCOPE(name) ((void)0)
+#endif
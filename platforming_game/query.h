@@ -0,0 +1,163 @@
+#pragma once
+#include <bitset>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "entity_handle.h"
+
+//included from entity.h, which defines MAX_COMPONENTS
+
+struct entity_manager;
+
+namespace query {
+    //view terms: plain component types are required and yielded as references,
+    //optional<T> is yielded as a T* (nullptr when missing) and exclude<T> filters out entities having T
+    template<class T>
+    struct optional {};
+
+    template<class T>
+    struct exclude {};
+
+    template<class T>
+    struct term {
+        static constexpr bool required = true;
+        static constexpr bool excluded = false;
+        using component = T;
+
+        template<class Manager>
+        static std::tuple<T&> fetch(Manager& em, entity_handle id) {
+            return std::tuple<T&>(*em.template get_component<T>(id));
+        }
+    };
+
+    template<class T>
+    struct term<optional<T>> {
+        static constexpr bool required = false;
+        static constexpr bool excluded = false;
+        using component = T;
+
+        template<class Manager>
+        static std::tuple<T*> fetch(Manager& em, entity_handle id) {
+            return std::tuple<T*>(em.template get_component<T>(id));
+        }
+    };
+
+    template<class T>
+    struct term<exclude<T>> {
+        static constexpr bool required = false;
+        static constexpr bool excluded = true;
+        using component = T;
+
+        template<class Manager>
+        static std::tuple<> fetch(Manager&, entity_handle) {
+            return std::tuple<>();
+        }
+    };
+}
+
+//list of the entities matching an include/exclude mask pair, kept up to date by the
+//entity_manager every time a component involved in the query is assigned or removed
+struct query_cache {
+    query_cache(const std::bitset<MAX_COMPONENTS>& include, const std::bitset<MAX_COMPONENTS>& exclude)
+        : include(include), exclude(exclude) {}
+
+    inline bool accepts(const std::bitset<MAX_COMPONENTS>& mask) const {
+        return (mask & include) == include && (mask & exclude).none();
+    }
+
+    inline bool contains(entity_handle id) const {
+        return id.index < index.size() && index[id.index] != 0;
+    }
+
+    //adds or drops the entity depending on its current mask
+    void update(entity_handle id, const std::bitset<MAX_COMPONENTS>& mask) {
+        bool matches = accepts(mask);
+        bool listed = contains(id);
+
+        if (matches && !listed) {
+            if (id.index >= index.size()) {
+                index.resize(id.index + 1, 0);
+            }
+            matches_list.push_back(id);
+            index[id.index] = matches_list.size();
+        }
+        else if (!matches && listed) {
+            //swap-and-pop, views iterate backwards so removing the current entity is safe
+            size_t slot = index[id.index] - 1;
+            entity_handle moved = matches_list.back();
+            matches_list[slot] = moved;
+            index[moved.index] = slot + 1;
+            matches_list.pop_back();
+            index[id.index] = 0;
+        }
+    }
+
+    std::bitset<MAX_COMPONENTS> include;
+    std::bitset<MAX_COMPONENTS> exclude;
+    std::vector<entity_handle> matches_list; //entities currently matching
+    std::vector<size_t> index; //entity slot -> position in matches_list + 1
+};
+
+//iterable set of entities matching a query. yields std::tuple<id, components...>
+//so it can be used with structured bindings:
+//  for (auto [id, position, movement] : em.view<components::position, components::movement>())
+//entities are visited from the back of the match list, which means the entity being visited can
+//lose its components or be deleted during the loop without skipping any other entity
+template<class... Ts>
+class basic_view {
+public:
+    using value_type = decltype(std::tuple_cat(std::tuple<entity_handle>(),
+        query::term<Ts>::fetch(std::declval<entity_manager&>(), entity_handle())...));
+
+    class iterator {
+    public:
+        iterator(basic_view* view, size_t remaining) : view(view), remaining(remaining) {}
+
+        value_type operator*() const {
+            return view->get(remaining - 1);
+        }
+
+        iterator& operator++() {
+            --remaining;
+            //entities deleted while iterating shrink the list under the iterator
+            if (remaining > view->size()) remaining = view->size();
+            return *this;
+        }
+
+        bool operator!=(const iterator& other) const {
+            return remaining != other.remaining;
+        }
+
+    private:
+        basic_view* view;
+        size_t remaining;
+    };
+
+    basic_view(entity_manager& em, query_cache* cache) : em(em), cache(cache) {}
+
+    iterator begin() {
+        return iterator(this, size());
+    }
+
+    iterator end() {
+        return iterator(this, 0);
+    }
+
+    inline size_t size() const {
+        return cache->matches_list.size();
+    }
+
+    inline entity_handle id(size_t i) const {
+        return cache->matches_list[i];
+    }
+
+    //components of the i-th matching entity
+    value_type get(size_t i) {
+        entity_handle entity_id = cache->matches_list[i];
+        return std::tuple_cat(std::tuple<entity_handle>(entity_id), query::term<Ts>::fetch(em, entity_id)...);
+    }
+
+private:
+    entity_manager& em;
+    query_cache* cache;
+};
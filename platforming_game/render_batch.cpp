@@ -0,0 +1,125 @@
+#include "render_batch.h"
+#include <algorithm>
+#include <functional>
+
+namespace {
+    inline bool same_color(SDL_Color a, SDL_Color b) {
+        return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+    }
+}
+
+Render_Batch::bucket& Render_Batch::find_bucket(int layer, SDL_Texture* texture, SDL_Color color) {
+    auto matches = [&](const bucket& candidate) {
+        return candidate.layer == layer && candidate.texture == texture && same_color(candidate.color, color);
+    };
+
+    if (last_bucket < buckets.size() && matches(buckets[last_bucket])) {
+        return buckets[last_bucket];
+    }
+
+    //a frame only has a few colors and textures, a linear search is enough
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        if (matches(buckets[i])) {
+            last_bucket = i;
+            return buckets[i];
+        }
+    }
+
+    buckets.push_back(bucket{ layer, texture, color, {}, {} });
+    last_bucket = buckets.size() - 1;
+    return buckets.back();
+}
+
+Render_Batch::bucket& Render_Batch::use_bucket(int layer, SDL_Texture* texture, SDL_Color color) {
+    bucket& target = find_bucket(layer, texture, color);
+    if (target.rects.empty()) {
+        order.push_back(static_cast<size_t>(&target - buckets.data()));
+    }
+    return target;
+}
+
+void Render_Batch::add_rect(const SDL_FRect& rect, SDL_Color color, int layer) {
+    use_bucket(layer, nullptr, color).rects.push_back(rect);
+}
+
+void Render_Batch::add_sprite(const SDL_FRect& rect, SDL_Texture* texture, const SDL_FRect& uv, SDL_Color tint, int layer) {
+    bucket& target = use_bucket(layer, texture, tint);
+    target.rects.push_back(rect);
+    target.uvs.push_back(uv);
+}
+
+void Render_Batch::submit(SDL_Renderer* renderer) {
+    stats = render_stats();
+
+    //layer first, then colored rects before sprites, and sprites of a texture next to each other.
+    //stable, so groups keep the order they first showed up in
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        const bucket& first = buckets[a];
+        const bucket& second = buckets[b];
+        if (first.layer != second.layer) return first.layer < second.layer;
+        return std::less<SDL_Texture*>()(first.texture, second.texture);
+    });
+
+    SDL_Texture* pending_texture = nullptr;
+
+    for (size_t index : order) {
+        bucket& current = buckets[index];
+        stats.rects += static_cast<int>(current.rects.size());
+
+        if (!current.texture && mode == batch_mode::FILL_RECTS) {
+            flush_geometry(renderer, pending_texture);
+
+            SDL_SetRenderDrawColor(renderer, current.color.r, current.color.g, current.color.b, current.color.a);
+            SDL_RenderFillRects(renderer, current.rects.data(), static_cast<int>(current.rects.size()));
+
+            stats.color_changes++;
+            stats.draw_calls++;
+            continue;
+        }
+
+        //consecutive buckets drawing with the same texture (or none) share one geometry call
+        if (current.texture != pending_texture) {
+            flush_geometry(renderer, pending_texture);
+            pending_texture = current.texture;
+        }
+        append_quads(current);
+    }
+
+    flush_geometry(renderer, pending_texture);
+
+    for (size_t index : order) {
+        buckets[index].rects.clear();
+        buckets[index].uvs.clear();
+    }
+    order.clear();
+}
+
+void Render_Batch::append_quads(const bucket& current) {
+    SDL_FColor color{ current.color.r / 255.0f, current.color.g / 255.0f, current.color.b / 255.0f, current.color.a / 255.0f };
+    bool textured = current.texture != nullptr;
+
+    for (size_t i = 0; i < current.rects.size(); ++i) {
+        const SDL_FRect& rect = current.rects[i];
+        SDL_FRect uv = textured ? current.uvs[i] : SDL_FRect{ 0.0f, 0.0f, 0.0f, 0.0f };
+        int first = static_cast<int>(vertices.size());
+
+        vertices.push_back(SDL_Vertex{ { rect.x, rect.y }, color, { uv.x, uv.y } });
+        vertices.push_back(SDL_Vertex{ { rect.x + rect.w, rect.y }, color, { uv.x + uv.w, uv.y } });
+        vertices.push_back(SDL_Vertex{ { rect.x + rect.w, rect.y + rect.h }, color, { uv.x + uv.w, uv.y + uv.h } });
+        vertices.push_back(SDL_Vertex{ { rect.x, rect.y + rect.h }, color, { uv.x, uv.y + uv.h } });
+
+        //two triangles per rect
+        indices.insert(indices.end(), { first, first + 1, first + 2, first, first + 2, first + 3 });
+    }
+}
+
+void Render_Batch::flush_geometry(SDL_Renderer* renderer, SDL_Texture* texture) {
+    if (vertices.empty()) return;
+
+    SDL_RenderGeometry(renderer, texture, vertices.data(), static_cast<int>(vertices.size()), indices.data(), static_cast<int>(indices.size()));
+    stats.draw_calls++;
+    if (texture) stats.texture_binds++;
+
+    vertices.clear();
+    indices.clear();
+}
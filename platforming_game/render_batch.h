@@ -0,0 +1,65 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <vector>
+
+//draw calls and primitives of the last submitted frame
+struct render_stats {
+    int draw_calls = 0;
+    int color_changes = 0;
+    int rects = 0; //colored rects and sprites
+    int texture_binds = 0; //draw calls using a texture
+};
+
+enum class batch_mode {
+    FILL_RECTS, //one SDL_RenderFillRects per color
+    GEOMETRY //colored rects in a single SDL_RenderGeometry call, colors go in the vertices
+};
+
+//collects the colored rects and sprites of a frame and submits them with a handful of draw calls
+//instead of one per rect. they are grouped per (layer, texture, color): lower layers are drawn first,
+//inside a layer colored rects go before sprites and sprites of a texture are drawn with one
+//SDL_RenderGeometry call in either mode. groups keep the order they first showed up in this frame,
+//so overlapping rects of the same layer from different groups may not keep the order they were added in
+class Render_Batch {
+public:
+    explicit Render_Batch(batch_mode mode = batch_mode::GEOMETRY) : mode(mode) {}
+
+    void add_rect(const SDL_FRect& rect, SDL_Color color, int layer = 0);
+
+    //textured quad, `uv` is the normalized part of the texture to draw and `tint` modulates it
+    void add_sprite(const SDL_FRect& rect, SDL_Texture* texture, const SDL_FRect& uv, SDL_Color tint, int layer = 0);
+
+    //draws everything added since the last submit and empties the batch
+    void submit(SDL_Renderer* renderer);
+
+    void set_mode(batch_mode new_mode) {
+        mode = new_mode;
+    }
+
+    const render_stats& last_stats() const {
+        return stats;
+    }
+
+private:
+    struct bucket {
+        int layer;
+        SDL_Texture* texture; //nullptr for colored rects
+        SDL_Color color;
+        std::vector<SDL_FRect> rects;
+        std::vector<SDL_FRect> uvs; //one per rect, sprites only
+    };
+
+    bucket& find_bucket(int layer, SDL_Texture* texture, SDL_Color color);
+    bucket& use_bucket(int layer, SDL_Texture* texture, SDL_Color color);
+    void append_quads(const bucket&);
+    void flush_geometry(SDL_Renderer* renderer, SDL_Texture* texture);
+
+    batch_mode mode;
+    std::vector<bucket> buckets; //kept between frames so the rect vectors keep their capacity
+    std::vector<size_t> order; //buckets used this frame, in draw order
+    size_t last_bucket = 0; //consecutive rects usually share a bucket
+
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+    render_stats stats;
+};
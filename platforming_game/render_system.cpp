@@ -0,0 +1,157 @@
+#include "render_system.h"
+
+Render_System::Render_System(entity_manager& em, batch_mode mode) : em(em), batch(mode) {}
+
+void Render_System::build_static_index() {
+    static_bodies.clear();
+    for (auto [id, render, position] : em.view<components::render, components::position, query::exclude<components::movement>>()) {
+        SDL_FRect box = render.sprite_rect;
+        box.x = static_cast<float>(position.pos.x);
+        box.y = static_cast<float>(position.pos.y);
+        static_bodies.push_back(broadphase_body{ id, box });
+    }
+
+    static_index.build(static_bodies);
+    static_index_built = true;
+}
+
+types::Vec2<double> Render_System::draw_position(const components::position& position, bool moving, double alpha) const {
+    //moving entities are drawn between their last two simulation states, static ones where they are
+    if (!moving) return position.pos;
+
+    types::Vec2<double> pos;
+    pos.x = position.previous_pos.x + (position.pos.x - position.previous_pos.x) * alpha;
+    pos.y = position.previous_pos.y + (position.pos.y - position.previous_pos.y) * alpha;
+    return pos;
+}
+
+void Render_System::follow_player(double alpha) {
+    //the player is the entity reading the keyboard
+    for (auto [id, position, render, key_binds, movement] : em.view<components::position, components::render, components::input, query::optional<components::movement>>()) {
+        types::Vec2<double> center = draw_position(position, movement != nullptr, alpha);
+        view_camera.x = center.x + render.sprite_rect.w * 0.5 - view_camera.width * 0.5;
+        view_camera.y = center.y + render.sprite_rect.h * 0.5 - view_camera.height * 0.5;
+        return;
+    }
+}
+
+bool Render_System::visible(const SDL_FRect& box) const {
+    //boxes are extended upwards so entities right below the screen still show their health bar
+    return box.x <= view_camera.x + view_camera.width && view_camera.x <= box.x + box.w &&
+        box.y - HEALTH_BAR_OFFSET <= view_camera.y + view_camera.height && view_camera.y <= box.y + box.h;
+}
+
+void Render_System::draw(const components::render& render, types::Vec2<double> world_pos, const components::health* health) {
+    float screen_x = static_cast<float>(world_pos.x - view_camera.x);
+    float screen_y = static_cast<float>(world_pos.y - view_camera.y);
+
+    SDL_FRect screen_rect{ screen_x, screen_y, render.sprite_rect.w, render.sprite_rect.h };
+
+    SDL_Texture* page = atlas.page_texture(render.sprite.page);
+    if (page) {
+        const types::atlas_region& region = render.sprite;
+        batch.add_sprite(screen_rect, page, { region.u0, region.v0, region.u1 - region.u0, region.v1 - region.v0 }, render.render_color);
+    }
+    else {
+        batch.add_rect(screen_rect, render.render_color);
+    }
+
+    if (health) {
+        SDL_FRect health_bar{ screen_x, screen_y - HEALTH_BAR_OFFSET, static_cast<float>(health->current_health), 10 };
+
+        //red health bar of entity on top of every sprite
+        batch.add_rect(health_bar, { 0xFF, 0x00, 0x00, 0xFF }, 1);
+    }
+}
+
+void Render_System::draw_tiles() {
+    int first_column, first_row, last_column, last_row;
+    SDL_FRect viewport{ static_cast<float>(view_camera.x), static_cast<float>(view_camera.y), view_camera.width, view_camera.height };
+    if (!tilemap || !tilemap->cell_range(viewport, first_column, first_row, last_column, last_row)) return;
+
+    for (int row = first_row; row <= last_row; ++row) {
+        for (int column = first_column; column <= last_column; ++column) {
+            std::uint16_t id = tilemap->get(column, row);
+            if (id == TILE_EMPTY) continue;
+
+            SDL_FRect cell = tilemap->cell_rect(column, row);
+            cell.x -= static_cast<float>(view_camera.x);
+            cell.y -= static_cast<float>(view_camera.y);
+            batch.add_rect(cell, tilemap->type(id).color);
+            culling.tiles++;
+        }
+    }
+}
+
+void Render_System::render(SDL_Renderer* renderer, double alpha) {
+    if (!static_index_built) {
+        build_static_index();
+    }
+
+    int output_width = 0;
+    int output_height = 0;
+    SDL_GetRenderOutputSize(renderer, &output_width, &output_height);
+    view_camera.width = static_cast<float>(output_width);
+    view_camera.height = static_cast<float>(output_height);
+
+    follow_player(alpha);
+
+    culling = culling_stats();
+    draw_tiles();
+
+    //static entities: only the ones the index finds in the viewport are touched
+    SDL_FRect viewport{ static_cast<float>(view_camera.x), static_cast<float>(view_camera.y),
+        view_camera.width, view_camera.height + HEALTH_BAR_OFFSET };
+    static_index.query(viewport, [&](const broadphase_body& body) {
+        auto* render = em.get_component<components::render>(body.id);
+        auto* position = em.get_component<components::position>(body.id);
+        if (!render || !position) return;
+
+        draw(*render, position->pos, em.get_component<components::health>(body.id));
+        culling.drawn++;
+    });
+
+    //moving entities with a collision component are looked up in the collision broadphase, the rest are all tested
+    int dynamic_count = 0;
+    auto draw_moving = [&](const components::render& render, const components::position& position, const components::health* health) {
+        types::Vec2<double> world_pos = draw_position(position, true, alpha);
+        SDL_FRect box{ static_cast<float>(world_pos.x), static_cast<float>(world_pos.y), render.sprite_rect.w, render.sprite_rect.h };
+        if (!visible(box)) return;
+
+        draw(render, world_pos, health);
+        culling.drawn++;
+    };
+
+    if (dynamic_index) {
+        SDL_FRect search{ viewport.x - RENDER_DYNAMIC_MARGIN, viewport.y - RENDER_DYNAMIC_MARGIN,
+            viewport.w + RENDER_DYNAMIC_MARGIN * 2.0f, viewport.h + RENDER_DYNAMIC_MARGIN * 2.0f };
+        dynamic_index->query(search, dynamic_candidates);
+
+        for (entity_handle id : dynamic_candidates) {
+            auto* render = em.get_component<components::render>(id);
+            auto* position = em.get_component<components::position>(id);
+            if (!render || !position || !em.has_component<components::movement>(id)) continue;
+
+            draw_moving(*render, *position, em.get_component<components::health>(id));
+        }
+        dynamic_count += static_cast<int>(dynamic_index->body_count());
+
+        auto unindexed = em.view<components::render, components::position, components::movement, query::exclude<components::collision>,
+            query::optional<components::health>>();
+        for (auto [id, render, position, movement, health] : unindexed) {
+            draw_moving(render, position, health);
+        }
+        dynamic_count += static_cast<int>(unindexed.size());
+    }
+    else {
+        auto moving = em.view<components::render, components::position, components::movement, query::optional<components::health>>();
+        for (auto [id, render, position, movement, health] : moving) {
+            draw_moving(render, position, health);
+        }
+        dynamic_count = static_cast<int>(moving.size());
+    }
+
+    culling.culled = static_cast<int>(static_index.size()) + dynamic_count - culling.drawn;
+
+    batch.submit(renderer);
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <vector>
+#include "bvh.h"
+#include "entity.h"
+#include "render_batch.h"
+#include "texture_atlas.h"
+#include "tilemap.h"
+
+#define HEALTH_BAR_OFFSET 30.0f //health bars are drawn this far above their entity
+//the collision broadphase is searched this far around the viewport: its boxes are hitboxes from before
+//collisions pushed the bodies out, and sprites can be larger than their hitbox
+#define RENDER_DYNAMIC_MARGIN 64.0f
+
+//world rectangle shown on screen, centered on the entity it follows
+struct camera {
+    double x = 0.0; //top left corner, in world coordinates
+    double y = 0.0;
+    float width = 0.0f;
+    float height = 0.0f;
+};
+
+//entities considered by the last frame
+struct culling_stats {
+    int drawn = 0;
+    int culled = 0;
+    int tiles = 0; //non empty tiles drawn
+};
+
+//draws every entity with a render and a position component through a Render_Batch, in camera space.
+//entities with an atlas region are drawn as sprites, the others as colored rects.
+//entities without movement are indexed once in a static BVH so only the visible ones are looked at.
+//moving ones are found through the collision broadphase when one is given, sleeping ones included at no
+//cost, otherwise every one of them is tested against the viewport
+class Render_System {
+public:
+    Render_System(entity_manager& em, batch_mode mode = batch_mode::GEOMETRY);
+
+    //indexes every render entity without a movement component. has to be called again whenever
+    //static level geometry is added or removed
+    void build_static_index();
+
+    //moving entities with a collision component are only looked for in the broadphase cells around the viewport.
+    //it has to outlive the system, nullptr goes back to testing every moving entity
+    void set_dynamic_index(const Broadphase* broadphase) {
+        dynamic_index = broadphase;
+    }
+
+    //tiles are drawn below the entities, only the cells inside the viewport are looked at.
+    //the map has to outlive the system, nullptr removes it
+    void set_tilemap(const Tilemap* map) {
+        tilemap = map;
+    }
+
+    //draws the world interpolated `alpha` of the way between the last two simulation steps
+    void render(SDL_Renderer* renderer, double alpha);
+
+    //images have to be added and the atlas built before regions are given to render components
+    Texture_Atlas& get_atlas() {
+        return atlas;
+    }
+
+    const camera& get_camera() const {
+        return view_camera;
+    }
+
+    const culling_stats& last_culling_stats() const {
+        return culling;
+    }
+
+    const render_stats& last_render_stats() const {
+        return batch.last_stats();
+    }
+
+private:
+    types::Vec2<double> draw_position(const components::position&, bool moving, double alpha) const;
+    void follow_player(double alpha);
+    void draw(const components::render&, types::Vec2<double>, const components::health*);
+    void draw_tiles();
+    bool visible(const SDL_FRect&) const;
+
+    entity_manager& em;
+    Render_Batch batch;
+    Texture_Atlas atlas;
+    Static_BVH static_index;
+    bool static_index_built = false;
+    const Tilemap* tilemap = nullptr;
+    std::vector<broadphase_body> static_bodies; //gathered when building the index
+    const Broadphase* dynamic_index = nullptr;
+    std::vector<entity_handle> dynamic_candidates; //found in the broadphase this frame
+
+    camera view_camera;
+    culling_stats culling;
+};
@@ -0,0 +1,50 @@
+#include "simd.h"
+
+#if SIMD_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+#if SIMD_X86
+    bool cpu_has_avx2() {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+
+        //the os has to save the ymm registers too
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        if (!osxsave || (_xgetbv(0) & 0x6) != 0x6) return false;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif
+}
+
+simd_isa best_simd_isa() {
+#if SIMD_X86
+    static const simd_isa best = cpu_has_avx2() ? simd_isa::AVX2 : simd_isa::SSE;
+    return best;
+#else
+    return simd_isa::SCALAR;
+#endif
+}
+
+const char* simd_isa_name(simd_isa isa) {
+    switch (isa) {
+    case simd_isa::SSE: return "sse";
+    case simd_isa::AVX2: return "avx2";
+    default: return "scalar";
+    }
+}
+
+simd_isa supported_simd_isa(simd_isa isa) {
+    simd_isa best = best_simd_isa();
+    return static_cast<int>(isa) > static_cast<int>(best) ? best : isa;
+}
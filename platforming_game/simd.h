@@ -0,0 +1,29 @@
+#pragma once
+
+//the SIMD kernels are written for x86-64, where SSE2 is always there and AVX2 is checked at runtime.
+//AVX2 functions are marked with SIMD_AVX2_TARGET so the rest of the program doesn't need it
+#if defined(__x86_64__) || defined(_M_X64)
+#define SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#define SIMD_AVX2_TARGET
+#else
+#define SIMD_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#else
+#define SIMD_X86 0
+#endif
+
+//instruction sets the kernels have a version for
+enum class simd_isa {
+    SCALAR,
+    SSE,
+    AVX2
+};
+
+//best version the cpu running the program supports, checked once
+simd_isa best_simd_isa();
+const char* simd_isa_name(simd_isa isa);
+
+//`isa` if the cpu supports it, otherwise the best one it does
+simd_isa supported_simd_isa(simd_isa isa);
@@ -0,0 +1,183 @@
+#include "simulation.h"
+#include "level.h"
+
+Simulation::Simulation(simulation_settings settings) : em(settings.storage), jobs(settings.threads), scheduler(jobs, em),
+    collision(em, settings.collision), movement_system(em, input, collision, &jobs), health_system(em, &jobs), streamer(em, settings.streaming) {
+
+    collision.set_tilemap(&tilemap);
+
+    //systems run in registration order unless their declared component access lets them share a stage
+    scheduler.add_system("movement", Movement_System::access(), [this](double dt) { movement_system.update(dt); });
+    scheduler.add_system("collision", Collision_System::access(), [this](double) { collision.update(); });
+    scheduler.add_system("health", Health_System::access(), [this](double dt) { health_system.update(dt); });
+}
+
+void Simulation::step(double delta_time) {
+    if (scripted) {
+        script.apply(tick_count, input);
+    }
+
+    scheduler.run(delta_time);
+    {
+        PROFILE_SCOPE("streaming");
+        if (streamer.update()) {
+            collision.build_static_tier();
+        }
+    }
+    input.clear_released();
+
+    if (scripted) {
+        input.advance_time(delta_time * 1000.0);
+    }
+
+    ++tick_count;
+}
+
+void Simulation::set_script(Input_Script new_script) {
+    script = std::move(new_script);
+    scripted = true;
+    input.use_manual_clock();
+}
+
+void Simulation::create_default_level() {
+    create_player(10.0, 10.0);
+    create_enemy(500.0, 10.0);
+
+    create_platform({ -500, 600, 1900, 200 }, { 0x00,0x00,0xFF,0xFF });
+    create_platform({ 800, 0, 200, 555 }, { 0x00,0xFF,0xFF,0xFF });
+
+    entity_handle death_ground = create_death_plane({ -1000, 800, 5000, 200 }, 20);
+
+    finish_level();
+
+    LOG_DEBUG("Death ID: {}", death_ground.index);
+}
+
+entity_handle Simulation::create_player(double x, double y) {
+    entity_handle player_id = em.new_entity();
+    em.assign_component<components::position>(player_id);
+    em.assign_component<components::movement>(player_id);
+    em.assign_component<components::render>(player_id);
+    em.assign_component<components::gravity>(player_id);
+    em.assign_component<components::input>(player_id);
+    em.assign_component<components::collision>(player_id);
+    em.assign_component<components::health>(player_id);
+    em.assign_component<components::jump>(player_id);
+
+    auto* player_position = em.get_component<components::position>(player_id);
+    player_position->pos = { x, y };
+    player_position->previous_pos = player_position->pos;
+
+    auto* player_movement = em.get_component<components::movement>(player_id);
+    player_movement->speed = { 0.0,0.0 };
+    player_movement->acceleration = { 2.0f,4.0f };
+
+    player_movement->max_speed = { 15.0,50.0 };
+    player_movement->max_acceleration = { 5.0,5.0 };
+
+    auto* player_sprite = em.get_component<components::render>(player_id);
+    player_sprite->sprite_rect = { static_cast<float>(player_position->pos.x), static_cast<float>(player_position->pos.y), 50,50 };
+    player_sprite->original_width = 50;
+    player_sprite->render_color = { 0x00,0xFF,0x00,0xFF };
+
+    auto* player_collision = em.get_component<components::collision>(player_id);
+    player_collision->hitbox.x = player_position->pos.x;
+    player_collision->hitbox.y = player_position->pos.y;
+    player_collision->hitbox.w = player_sprite->sprite_rect.w;
+    player_collision->hitbox.h = player_sprite->sprite_rect.h;
+
+    auto* player_health = em.get_component <components::health>(player_id);
+    player_health->max_health = 100;
+    player_health->current_health = player_health->max_health;
+    player_health->i_frames = 5;
+
+    return player_id;
+}
+
+entity_handle Simulation::create_enemy(double x, double y) {
+    entity_handle enemy_id = em.new_entity();
+    em.assign_component<components::position>(enemy_id);
+    em.assign_component<components::render>(enemy_id);
+    em.assign_component<components::movement>(enemy_id);
+    em.assign_component<components::gravity>(enemy_id);
+    em.assign_component<components::collision>(enemy_id);
+    em.assign_component<components::damage>(enemy_id);
+
+    auto* enemy_position = em.get_component<components::position>(enemy_id);
+    enemy_position->pos = { x, y };
+    enemy_position->previous_pos = enemy_position->pos;
+
+    auto* enemy_movement = em.get_component<components::movement>(enemy_id);
+    enemy_movement->speed = { 0.0,0.0 };
+    enemy_movement->acceleration = { 5.0f,5.0f };
+
+    enemy_movement->max_speed = { 100.0,100.0 };
+    enemy_movement->max_acceleration = { 5.0,5.0 };
+
+    auto* enemy_render = em.get_component<components::render>(enemy_id);
+    enemy_render->sprite_rect = { static_cast<float>(enemy_position->pos.x), static_cast<float>(enemy_position->pos.y), 30, 30 };
+
+    auto* enemy_collision = em.get_component<components::collision>(enemy_id);
+    enemy_collision->hitbox.x = enemy_position->pos.x;
+    enemy_collision->hitbox.y = enemy_position->pos.y;
+    enemy_collision->hitbox.w = enemy_render->sprite_rect.w;
+    enemy_collision->hitbox.h = enemy_render->sprite_rect.h;
+    enemy_collision->is_rigid = false;
+
+    auto* enemy_damage = em.get_component<components::damage>(enemy_id);
+    enemy_damage->damage_amount = 5;
+
+    return enemy_id;
+}
+
+entity_handle Simulation::create_platform(SDL_FRect rect, SDL_Color color) {
+    //platforms don't need movement or input components, only collisions and renders
+    entity_handle platform_id = em.new_entity();
+    em.assign_component<components::position>(platform_id);
+    em.assign_component<components::collision>(platform_id);
+    em.assign_component<components::render>(platform_id);
+
+    auto* platform_position = em.get_component<components::position>(platform_id);
+    platform_position->pos.x = rect.x;
+    platform_position->pos.y = rect.y;
+    platform_position->previous_pos = platform_position->pos;
+
+    auto* platform_render = em.get_component<components::render>(platform_id);
+    platform_render->sprite_rect = rect;
+    platform_render->original_width = static_cast<int>(rect.w);
+    platform_render->render_color = color;
+
+    auto* platform_collision = em.get_component<components::collision>(platform_id);
+    platform_collision->hitbox = rect;
+    platform_collision->is_rigid = true;
+
+    return platform_id;
+}
+
+entity_handle Simulation::create_death_plane(SDL_FRect rect, int damage) {
+    entity_handle death_id = em.new_entity();
+    em.assign_component<components::collision>(death_id);
+    em.assign_component<components::damage>(death_id);
+
+    auto* death_collision = em.get_component<components::collision>(death_id);
+    death_collision->hitbox = rect;
+    death_collision->is_rigid = true;
+
+    auto* death_damage = em.get_component<components::damage>(death_id);
+    death_damage->damage_amount = damage;
+
+    return death_id;
+}
+
+bool Simulation::load_level(const std::string& path) {
+    size_t entity_count = 0;
+    if (!streamer.load_level(path, entity_count, &tilemap)) return false;
+
+    finish_level();
+    return true;
+}
+
+void Simulation::finish_level() {
+    //level geometry won't move anymore
+    collision.build_static_tier();
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <string>
+#include <thread>
+#include "entity.h"
+#include "health_system.h"
+#include "input.h"
+#include "job_system.h"
+#include "movement.h"
+#include "world_streamer.h"
+
+#define SIMULATION_RATE 120 //fixed simulation steps per second
+
+struct simulation_settings {
+    broadphase_settings collision;
+    storage_mode storage = storage_mode::SPARSE_SET;
+    unsigned int threads = std::thread::hardware_concurrency(); //includes the calling thread
+    streaming_settings streaming;
+};
+
+//the game world and the systems that step it, without any window or renderer. Game draws it,
+//headless runs (benchmarks, build machines without a display) only step it
+class Simulation {
+public:
+    Simulation(simulation_settings settings = simulation_settings());
+
+    //runs every system once, then streams chunks around the players. with a script, its events for
+    //this tick are applied first and the input clock advances by delta_time instead of following the real time
+    void step(double delta_time);
+
+    void set_script(Input_Script new_script);
+
+    unsigned long long tick() const {
+        return tick_count;
+    }
+
+    //the level Game::init used to build: ground, wall, death plane, a player and an enemy
+    void create_default_level();
+
+    entity_handle create_player(double x, double y);
+    entity_handle create_enemy(double x, double y);
+    entity_handle create_platform(SDL_FRect rect, SDL_Color color);
+    entity_handle create_death_plane(SDL_FRect rect, int damage);
+
+    //builds the level in a text or cooked (.lvlb) level file, see level.h, tilemap included. only the chunks
+    //around the players are created, the streamer keeps the rest. false if it couldn't be loaded
+    bool load_level(const std::string& path);
+
+    //level geometry is done, call after every platform and death plane has been created
+    void finish_level();
+
+    entity_manager em;
+    Tilemap tilemap; //static geometry loaded from tile levels, empty otherwise
+    Input_Handler input;
+
+    Thread_Pool jobs;
+    System_Scheduler scheduler;
+
+    Collision_System collision;
+    Movement_System movement_system;
+    Health_System health_system;
+
+    World_Streamer streamer; //runs after the systems, rebuilds the collision static tier when chunks change
+
+private:
+    Input_Script script;
+    bool scripted = false;
+    unsigned long long tick_count = 0;
+};
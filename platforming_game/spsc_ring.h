@@ -0,0 +1,37 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+//fixed size single producer single consumer queue: one thread pushes, another one drains, neither locks.
+//Size has to be a power of two. used for the per thread buffers of the profiler and the logger
+template<class T, size_t Size>
+class spsc_ring {
+    static_assert((Size & (Size - 1)) == 0, "the ring size has to be a power of two");
+
+public:
+    //false if the ring is full, the value is dropped
+    bool push(const T& value) {
+        size_t write = head.load(std::memory_order_relaxed);
+        if (write - tail.load(std::memory_order_acquire) == Size) return false;
+
+        values[write & (Size - 1)] = value;
+        head.store(write + 1, std::memory_order_release);
+        return true;
+    }
+
+    //calls fn(const T&) for every value pushed so far and frees their slots
+    template<class Fn>
+    void drain(Fn&& fn) {
+        size_t read = tail.load(std::memory_order_relaxed);
+        size_t write = head.load(std::memory_order_acquire);
+        for (; read != write; ++read) {
+            fn(values[read & (Size - 1)]);
+        }
+        tail.store(read, std::memory_order_release);
+    }
+
+private:
+    alignas(64) std::atomic<size_t> head{ 0 };
+    alignas(64) std::atomic<size_t> tail{ 0 };
+    T values[Size];
+};
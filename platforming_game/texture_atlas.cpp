@@ -0,0 +1,162 @@
+#include "texture_atlas.h"
+#include <algorithm>
+#include "logger.h"
+
+Texture_Atlas::~Texture_Atlas() {
+    release();
+}
+
+void Texture_Atlas::release() {
+    for (SDL_Texture* page : pages) {
+        SDL_DestroyTexture(page);
+    }
+    pages.clear();
+
+    std::lock_guard<std::mutex> guard(lock);
+    for (auto& page : page_surfaces) {
+        SDL_DestroySurface(page.pixels);
+    }
+    page_surfaces.clear();
+    pending.clear();
+    pending_begin = 0;
+    inserted = 0;
+    uploaded = 0;
+    regions.clear();
+}
+
+int Texture_Atlas::find_space(int width, int height, int& x, int& y) {
+    //only the last page is filled, earlier ones are full or hold an oversized image
+    if (!page_surfaces.empty()) {
+        page_surface& last = page_surfaces.back();
+
+        //next shelf when the row is full
+        if (last.shelf_x + width > last.pixels->w) {
+            last.shelf_y += last.shelf_height;
+            last.shelf_x = 0;
+            last.shelf_height = 0;
+        }
+
+        if (last.shelf_x + width <= last.pixels->w && last.shelf_y + height <= last.pixels->h) {
+            x = last.shelf_x;
+            y = last.shelf_y;
+            last.shelf_x += width;
+            last.shelf_height = std::max(last.shelf_height, height);
+            return static_cast<int>(page_surfaces.size()) - 1;
+        }
+    }
+
+    //images larger than a page get a page of their own size
+    int page_width = std::max(ATLAS_PAGE_SIZE, width);
+    int page_height = std::max(ATLAS_PAGE_SIZE, height);
+
+    SDL_Surface* pixels = SDL_CreateSurface(page_width, page_height, SDL_PIXELFORMAT_RGBA32);
+    if (!pixels) return -1;
+    SDL_FillSurfaceRect(pixels, nullptr, 0);
+
+    page_surfaces.push_back(page_surface{ pixels, width, 0, height });
+    x = 0;
+    y = 0;
+    return static_cast<int>(page_surfaces.size()) - 1;
+}
+
+types::atlas_region Texture_Atlas::insert(const std::string& name, SDL_Surface* surface, unsigned long long& ticket) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    int x = 0;
+    int y = 0;
+    int page = find_space(surface->w + ATLAS_PADDING, surface->h + ATLAS_PADDING, x, y);
+    if (page < 0) {
+        LOG_ERROR("Could not create atlas page: {}", SDL_GetError());
+        return types::atlas_region();
+    }
+
+    SDL_Surface* page_pixels = page_surfaces[page].pixels;
+    SDL_Rect target{ x, y, surface->w, surface->h };
+
+    //copy the alpha channel as is instead of blending with the empty page
+    SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+    SDL_BlitSurface(surface, nullptr, page_pixels, &target);
+
+    types::atlas_region region;
+    region.page = page;
+    region.u0 = static_cast<float>(x) / page_pixels->w;
+    region.v0 = static_cast<float>(y) / page_pixels->h;
+    region.u1 = static_cast<float>(x + surface->w) / page_pixels->w;
+    region.v1 = static_cast<float>(y + surface->h) / page_pixels->h;
+    regions[name] = region;
+
+    pending.push_back(pending_upload{ page, target });
+    ticket = inserted++;
+    return region;
+}
+
+size_t Texture_Atlas::upload(SDL_Renderer* renderer, double budget_seconds) {
+    const Uint64 frequency = SDL_GetPerformanceFrequency();
+    const Uint64 start = SDL_GetPerformanceCounter();
+    size_t done = 0;
+
+    while (true) {
+        pending_upload next;
+        SDL_Surface* page_pixels;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (pending_begin == pending.size()) {
+                pending.clear();
+                pending_begin = 0;
+                break;
+            }
+
+            next = pending[pending_begin];
+            page_pixels = page_surfaces[next.page].pixels;
+        }
+
+        //pages get their texture the first time something is uploaded to them
+        while (static_cast<int>(pages.size()) <= next.page) {
+            pages.push_back(nullptr);
+        }
+        if (!pages[next.page]) {
+            pages[next.page] = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, page_pixels->w, page_pixels->h);
+            if (pages[next.page]) {
+                SDL_SetTextureBlendMode(pages[next.page], SDL_BLENDMODE_BLEND);
+                SDL_SetTextureScaleMode(pages[next.page], SDL_SCALEMODE_NEAREST);
+            }
+            else {
+                LOG_ERROR("Could not create atlas texture: {}", SDL_GetError());
+            }
+        }
+
+        //the rect was fully written before it was queued and nothing writes it again
+        if (pages[next.page]) {
+            const char* first_pixel = static_cast<const char*>(page_pixels->pixels) + next.rect.y * page_pixels->pitch + next.rect.x * 4;
+            SDL_UpdateTexture(pages[next.page], &next.rect, first_pixel, page_pixels->pitch);
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            pending_begin++;
+            uploaded++;
+        }
+        done++;
+
+        if (static_cast<double>(SDL_GetPerformanceCounter() - start) / frequency >= budget_seconds) break;
+    }
+
+    return done;
+}
+
+unsigned long long Texture_Atlas::uploaded_count() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return uploaded;
+}
+
+bool Texture_Atlas::has_pending_uploads() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return pending_begin < pending.size();
+}
+
+types::atlas_region Texture_Atlas::find(const std::string& name) const {
+    std::lock_guard<std::mutex> guard(lock);
+    auto found = regions.find(name);
+    if (found == regions.end()) return types::atlas_region();
+    return found->second;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "entity.h"
+
+#define ATLAS_PAGE_SIZE 2048 //width and height of an atlas page, in pixels
+#define ATLAS_PADDING 1 //empty pixels between packed images so filtering doesn't bleed across them
+
+//packs images into as few textures (pages) as possible, so sprites sharing a page can be drawn with
+//a single draw call. images are shelf packed into a cpu copy of their page as they come, from any
+//thread, and copied to the gpu later by the thread owning the renderer, a few at a time
+class Texture_Atlas {
+public:
+    ~Texture_Atlas();
+
+    //packs an RGBA32 surface and returns its region and upload ticket. the region can't be drawn
+    //before uploaded_count() goes past the ticket. thread safe, the caller keeps the surface
+    types::atlas_region insert(const std::string& name, SDL_Surface* surface, unsigned long long& ticket);
+
+    //copies pending images to their page textures, in insertion order, until `budget_seconds` is
+    //spent (at least one image per call). renderer thread only, returns the images uploaded
+    size_t upload(SDL_Renderer* renderer, double budget_seconds);
+
+    //images whose upload is done, every ticket below it can be drawn
+    unsigned long long uploaded_count() const;
+
+    bool has_pending_uploads() const;
+
+    //region of an inserted image, page -1 when there is no image with that name
+    types::atlas_region find(const std::string& name) const;
+
+    SDL_Texture* page_texture(int page) const {
+        return page >= 0 && page < static_cast<int>(pages.size()) ? pages[page] : nullptr;
+    }
+
+    size_t page_count() const {
+        return pages.size();
+    }
+
+    //destroys every page and forgets the images, the atlas is empty afterwards. renderer thread only,
+    //the textures have to go before their renderer does. the destructor calls it too
+    void release();
+
+private:
+    struct page_surface {
+        SDL_Surface* pixels; //cpu copy, images are blitted here before their upload
+        int shelf_x;
+        int shelf_y;
+        int shelf_height;
+    };
+
+    struct pending_upload {
+        int page;
+        SDL_Rect rect;
+    };
+
+    int find_space(int width, int height, int& x, int& y);
+
+    mutable std::mutex lock;
+    std::vector<page_surface> page_surfaces;
+    std::vector<pending_upload> pending; //in ticket order, starting at ticket `uploaded`
+    size_t pending_begin = 0;
+    unsigned long long inserted = 0;
+    unsigned long long uploaded = 0;
+    std::unordered_map<std::string, types::atlas_region> regions;
+
+    std::vector<SDL_Texture*> pages; //renderer thread only
+};
@@ -0,0 +1,39 @@
+#include "tilemap.h"
+#include <algorithm>
+#include <cmath>
+
+Tilemap::Tilemap(int width, int height, float tile_size, float origin_x, float origin_y)
+    : width(width), height(height), tile_size(tile_size), origin_x(origin_x), origin_y(origin_y),
+    tiles(static_cast<size_t>(width) * height, TILE_EMPTY) {}
+
+void Tilemap::define_tile(std::uint16_t id, const tile_type& type) {
+    if (id == TILE_EMPTY) return;
+
+    if (types.size() <= id) {
+        types.resize(id + 1);
+    }
+    types[id] = type;
+}
+
+void Tilemap::set(int column, int row, std::uint16_t id) {
+    if (column < 0 || row < 0 || column >= width || row >= height) return;
+    tiles[static_cast<size_t>(row) * width + column] = id;
+}
+
+bool Tilemap::cell_range(const SDL_FRect& box, int& first_column, int& first_row, int& last_column, int& last_row) const {
+    if (tiles.empty()) return false;
+
+    //a box ending exactly on a cell edge doesn't reach into the next cell
+    first_column = static_cast<int>(std::floor((box.x - origin_x) / tile_size));
+    first_row = static_cast<int>(std::floor((box.y - origin_y) / tile_size));
+    last_column = static_cast<int>(std::ceil((box.x + box.w - origin_x) / tile_size)) - 1;
+    last_row = static_cast<int>(std::ceil((box.y + box.h - origin_y) / tile_size)) - 1;
+
+    if (last_column < 0 || last_row < 0 || first_column >= width || first_row >= height) return false;
+
+    first_column = std::max(first_column, 0);
+    first_row = std::max(first_row, 0);
+    last_column = std::min(last_column, width - 1);
+    last_row = std::min(last_row, height - 1);
+    return first_column <= last_column && first_row <= last_row;
+}
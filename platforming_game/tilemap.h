@@ -0,0 +1,61 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <cstdint>
+#include <vector>
+
+#define TILE_EMPTY 0 //tile id of cells with nothing in them
+
+//what a tile id stands for
+struct tile_type {
+    SDL_Color color = { 0xFF,0xFF,0xFF,0xFF };
+    bool solid = false; //dynamic bodies are pushed out of solid tiles
+    int damage = 0; //dealt to bodies with health touching the tile, like a damage component
+};
+
+//static level geometry as a dense grid of tile ids. a body only looks at the cells its hitbox
+//overlaps, so colliding with the tilemap costs the same however large the level is
+class Tilemap {
+public:
+    Tilemap() = default;
+    Tilemap(int width, int height, float tile_size, float origin_x = 0.0f, float origin_y = 0.0f);
+
+    //types are indexed by tile id, TILE_EMPTY is defined as an empty non solid tile
+    void define_tile(std::uint16_t id, const tile_type& type);
+
+    void set(int column, int row, std::uint16_t id);
+
+    //cells outside the map are empty
+    std::uint16_t get(int column, int row) const {
+        if (column < 0 || row < 0 || column >= width || row >= height) return TILE_EMPTY;
+        return tiles[static_cast<size_t>(row) * width + column];
+    }
+
+    const tile_type& type(std::uint16_t id) const {
+        return id < types.size() ? types[id] : types[TILE_EMPTY];
+    }
+
+    bool solid(int column, int row) const {
+        return type(get(column, row)).solid;
+    }
+
+    //cells overlapped by a world space rect, clamped to the map. false if it misses the map
+    bool cell_range(const SDL_FRect& box, int& first_column, int& first_row, int& last_column, int& last_row) const;
+
+    //world space rect of a cell
+    SDL_FRect cell_rect(int column, int row) const {
+        return { origin_x + column * tile_size, origin_y + row * tile_size, tile_size, tile_size };
+    }
+
+    bool empty() const {
+        return tiles.empty();
+    }
+
+    int width = 0;
+    int height = 0;
+    float tile_size = 32.0f;
+    float origin_x = 0.0f; //world position of the top left corner of cell (0, 0)
+    float origin_y = 0.0f;
+
+    std::vector<std::uint16_t> tiles; //row major
+    std::vector<tile_type> types = std::vector<tile_type>(1); //TILE_EMPTY is always defined
+};
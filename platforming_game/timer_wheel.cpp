@@ -0,0 +1,167 @@
+#include "timer_wheel.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    const unsigned long long max_delay = (1ull << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1;
+}
+
+Timer_Wheel::Timer_Wheel(double tick_seconds) : tick_seconds(tick_seconds) {
+    slots.fill(TIMER_NULL_INDEX);
+}
+
+unsigned long long Timer_Wheel::to_ticks(double seconds) const {
+    double ticks = std::round(seconds / tick_seconds);
+    return ticks < 1.0 ? 1 : static_cast<unsigned long long>(ticks);
+}
+
+timer_handle Timer_Wheel::schedule(double delay, timer_function fn, void* context, entity_handle entity, double period) {
+    std::uint32_t index = free_head;
+    if (index != TIMER_NULL_INDEX) {
+        free_head = timers[index].next;
+    }
+    else {
+        index = static_cast<std::uint32_t>(timers.size());
+        timers.emplace_back();
+    }
+
+    timer& t = timers[index];
+    t.expiry = current + to_ticks(delay);
+    t.period = period > 0.0 ? to_ticks(period) : 0;
+    t.fn = fn;
+    t.context = context;
+    t.entity = entity;
+    t.sequence = next_sequence++;
+
+    insert(index);
+    active_count++;
+    return timer_handle{ index, t.generation };
+}
+
+bool Timer_Wheel::active(timer_handle handle) const {
+    return handle.index < timers.size() && timers[handle.index].generation == handle.generation && timers[handle.index].slot != FREE;
+}
+
+bool Timer_Wheel::cancel(timer_handle handle) {
+    if (!active(handle)) return false;
+
+    //a due timer isn't linked anywhere, run_tick skips it once its generation changed
+    if (timers[handle.index].slot != DUE) {
+        unlink(handle.index);
+    }
+    release(handle.index);
+    return true;
+}
+
+void Timer_Wheel::insert(std::uint32_t index) {
+    timer& t = timers[index];
+
+    //the level is the first one whose turn covers the delay, the slot comes from the expiry bits of that level
+    unsigned long long delay = std::min(t.expiry - current, max_delay);
+    unsigned long long expiry = current + delay;
+
+    std::uint32_t level = 0;
+    while (level + 1 < TIMER_WHEEL_LEVELS && delay >= (1ull << (TIMER_WHEEL_BITS * (level + 1)))) {
+        level++;
+    }
+
+    std::uint32_t slot = level * slot_count + static_cast<std::uint32_t>((expiry >> (TIMER_WHEEL_BITS * level)) & (slot_count - 1));
+
+    t.slot = slot;
+    t.previous = TIMER_NULL_INDEX;
+    t.next = slots[slot];
+    if (t.next != TIMER_NULL_INDEX) {
+        timers[t.next].previous = index;
+    }
+    slots[slot] = index;
+}
+
+void Timer_Wheel::unlink(std::uint32_t index) {
+    timer& t = timers[index];
+    if (t.previous != TIMER_NULL_INDEX) timers[t.previous].next = t.next;
+    else slots[t.slot] = t.next;
+    if (t.next != TIMER_NULL_INDEX) timers[t.next].previous = t.previous;
+
+    t.next = TIMER_NULL_INDEX;
+    t.previous = TIMER_NULL_INDEX;
+}
+
+void Timer_Wheel::release(std::uint32_t index) {
+    timer& t = timers[index];
+    t.generation++;
+    t.slot = FREE;
+    t.fn = nullptr;
+    t.context = nullptr;
+    t.next = free_head;
+    free_head = index;
+    active_count--;
+}
+
+void Timer_Wheel::cascade(std::uint32_t slot) {
+    std::uint32_t index = slots[slot];
+    slots[slot] = TIMER_NULL_INDEX;
+
+    while (index != TIMER_NULL_INDEX) {
+        std::uint32_t next = timers[index].next;
+        insert(index);
+        index = next;
+    }
+}
+
+void Timer_Wheel::advance(double seconds) {
+    last_fired = 0;
+    pending_time += seconds;
+
+    //a small tolerance so steps of exactly one tick don't lose one to rounding
+    while (pending_time >= tick_seconds * (1.0 - 1e-9)) {
+        pending_time -= tick_seconds;
+        run_tick();
+    }
+    pending_time = std::max(pending_time, 0.0);
+}
+
+void Timer_Wheel::run_tick() {
+    std::uint32_t index = static_cast<std::uint32_t>(current & (slot_count - 1));
+
+    //every time a level wraps around, the next slot of the level above moves down
+    for (std::uint32_t level = 1; index == 0 && level < TIMER_WHEEL_LEVELS; ++level) {
+        index = static_cast<std::uint32_t>((current >> (TIMER_WHEEL_BITS * level)) & (slot_count - 1));
+        cascade(level * slot_count + index);
+    }
+    index = static_cast<std::uint32_t>(current & (slot_count - 1));
+
+    //taken out of the slot before any callback runs, so the ones they schedule wait for a later tick
+    due.clear();
+    for (std::uint32_t timer_index = slots[index]; timer_index != TIMER_NULL_INDEX; timer_index = timers[timer_index].next) {
+        due.push_back(due_timer{ timer_index, timers[timer_index].generation, timers[timer_index].sequence });
+    }
+    for (auto& entry : due) {
+        timers[entry.index].slot = DUE;
+    }
+    slots[index] = TIMER_NULL_INDEX;
+
+    std::sort(due.begin(), due.end(), [](const due_timer& a, const due_timer& b) { return a.sequence < b.sequence; });
+
+    for (auto& entry : due) {
+        timer& t = timers[entry.index];
+        if (t.generation != entry.generation || t.slot != DUE) continue; //cancelled by an earlier callback
+
+        timer_function fn = t.fn;
+        void* context = t.context;
+        entity_handle entity = t.entity;
+
+        //periodic timers are back in the wheel before the callback runs, so it can cancel them
+        if (t.period > 0) {
+            t.expiry = current + t.period;
+            insert(entry.index);
+        }
+        else {
+            release(entry.index);
+        }
+
+        last_fired++;
+        fn(context, entity);
+    }
+
+    current++;
+}
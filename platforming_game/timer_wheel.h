@@ -0,0 +1,98 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "entity_handle.h"
+
+#define TIMER_WHEEL_BITS 6 //slots per level are 1 << bits
+#define TIMER_WHEEL_LEVELS 4 //delays up to 2^(bits * levels) ticks, longer ones are clamped
+#define TIMER_TICK_SECONDS (1.0 / 120.0) //one simulation step
+
+#define TIMER_NULL_INDEX 0xFFFFFFFFu
+
+//a scheduled timer, stale once it fired (one-shot) or was cancelled
+struct timer_handle {
+    std::uint32_t index = TIMER_NULL_INDEX;
+    std::uint32_t generation = 0;
+};
+
+//called when a timer fires with the context and entity it was scheduled with
+using timer_function = void (*)(void* context, entity_handle entity);
+
+//hierarchical timer wheel: level 0 has one slot per tick, every next level one slot per whole turn
+//of the level below. a timer goes into the level its delay fits in and moves down a level every time
+//the level below wraps around, so advancing only touches the timers that fire or cascade that tick,
+//never the whole set. timers are intrusive lists over a pool, scheduling and cancelling are O(1)
+class Timer_Wheel {
+public:
+    explicit Timer_Wheel(double tick_seconds = TIMER_TICK_SECONDS);
+
+    //fires fn(context, entity) after `delay` seconds, then every `period` seconds if it is above 0.
+    //both are rounded to whole ticks, at least one
+    timer_handle schedule(double delay, timer_function fn, void* context, entity_handle entity = entity_handle(), double period = 0.0);
+
+    //false if the timer already fired or was cancelled
+    bool cancel(timer_handle timer);
+    bool active(timer_handle timer) const;
+
+    //runs every tick the elapsed time covers, firing their timers in the order they were scheduled.
+    //callbacks may schedule and cancel timers, including the one firing
+    void advance(double seconds);
+
+    //ticks run so far
+    unsigned long long now() const {
+        return current;
+    }
+
+    size_t size() const {
+        return active_count;
+    }
+
+    //timers fired by the last advance
+    size_t fired() const {
+        return last_fired;
+    }
+
+private:
+    static constexpr std::uint32_t slot_count = 1u << TIMER_WHEEL_BITS;
+    static constexpr std::uint32_t FREE = 0xFFFFFFFFu;
+    static constexpr std::uint32_t DUE = 0xFFFFFFFEu; //taken out of its slot to fire this tick
+
+    struct timer {
+        unsigned long long expiry = 0; //tick it fires on
+        unsigned long long period = 0; //ticks, 0 for one-shot timers
+        timer_function fn = nullptr;
+        void* context = nullptr;
+        entity_handle entity;
+        unsigned long long sequence = 0; //timers due on the same tick fire in this order
+        std::uint32_t generation = 0;
+        std::uint32_t slot = FREE; //level * slot_count + slot it is linked in, or FREE / DUE
+        std::uint32_t next = TIMER_NULL_INDEX; //in its slot, or in the free list
+        std::uint32_t previous = TIMER_NULL_INDEX;
+    };
+
+    struct due_timer {
+        std::uint32_t index;
+        std::uint32_t generation;
+        unsigned long long sequence;
+    };
+
+    unsigned long long to_ticks(double seconds) const;
+    void insert(std::uint32_t index);
+    void unlink(std::uint32_t index);
+    void release(std::uint32_t index);
+    void cascade(std::uint32_t slot);
+    void run_tick();
+
+    double tick_seconds;
+    double pending_time = 0.0; //time advanced that doesn't make a whole tick yet
+    unsigned long long current = 0; //next tick to run
+    std::vector<timer> timers;
+    std::uint32_t free_head = TIMER_NULL_INDEX;
+    std::array<std::uint32_t, slot_count * TIMER_WHEEL_LEVELS> slots; //first timer of every slot
+    std::vector<due_timer> due; //timers of the tick being run
+    unsigned long long next_sequence = 0;
+    size_t active_count = 0;
+    size_t last_fired = 0;
+};
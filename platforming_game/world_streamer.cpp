@@ -0,0 +1,433 @@
+#include "world_streamer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include "logger.h"
+
+namespace {
+    double milliseconds_since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+bool World_Streamer::chunk_ranges::overlaps(int first, int last) const {
+    //first range ending at or after `first`, the ranges are sorted so their ends are too
+    auto found = std::lower_bound(ranges.begin(), ranges.end(), first,
+        [](const std::pair<int, int>& range, int value) { return range.second < value; });
+    return found != ranges.end() && found->first <= last;
+}
+
+World_Streamer::World_Streamer(entity_manager& em, streaming_settings settings) : em(em), settings(settings) {}
+
+World_Streamer::~World_Streamer() {
+    if (owns_directory) {
+        std::error_code error;
+        std::filesystem::remove_all(directory, error);
+    }
+}
+
+bool World_Streamer::load_level(const std::string& path, size_t& entity_count, Tilemap* tilemap) {
+    return with_cooked_level(path, [&](const unsigned char* data, size_t size) {
+        cooked_level level;
+        std::string error;
+        if (!read_cooked(data, size, level, error)) {
+            LOG_ERROR("Could not load level {}, {}", path, error);
+            return false;
+        }
+
+        if (!settings.enabled || !split_level(level)) {
+            instantiate_cooked(em, level);
+        }
+
+        if (tilemap && !level.tilemap.empty()) {
+            *tilemap = std::move(level.tilemap);
+        }
+        entity_count = level.entity_count;
+        return true;
+    });
+}
+
+bool World_Streamer::split_level(const cooked_level& level) {
+    //what entity_chunks reads from a live entity, gathered from the columns
+    struct entity_bounds {
+        double x = 0.0;
+        float width = 0.0f;
+        SDL_FRect hitbox{};
+        bool positioned = false;
+        bool collides = false;
+        bool player = false;
+    };
+    std::vector<entity_bounds> bounds(level.entity_count);
+
+    for (auto& column : level.columns) {
+        for (size_t row = 0; row < column.count; ++row) {
+            entity_bounds& entity = bounds[column.rows[row]];
+            const unsigned char* value = column.values + row * column.size;
+
+            if (column.component_id == components::get_id<components::position>()) {
+                entity.x = reinterpret_cast<const components::position*>(value)->pos.x;
+                entity.positioned = true;
+            }
+            else if (column.component_id == components::get_id<components::render>()) {
+                entity.width = reinterpret_cast<const components::render*>(value)->sprite_rect.w;
+            }
+            else if (column.component_id == components::get_id<components::collision>()) {
+                entity.hitbox = reinterpret_cast<const components::collision*>(value)->hitbox;
+                entity.collides = true;
+            }
+            else if (column.component_id == components::get_id<components::input>()) {
+                entity.player = true;
+            }
+        }
+    }
+
+    player_chunks.clear();
+    for (auto& entity : bounds) {
+        if (entity.player && entity.positioned) player_chunks.push_back(chunk_of(entity.x));
+    }
+    if (player_chunks.empty()) return false;
+
+    std::sort(player_chunks.begin(), player_chunks.end());
+    player_chunks.erase(std::unique(player_chunks.begin(), player_chunks.end()), player_chunks.end());
+
+    chunk_ranges active = ranges_around(settings.active_radius);
+    live_chunks.clear();
+
+    //group 0 is created now, every other group is the inactive chunk group_chunks[group - 1]
+    std::vector<std::uint32_t> group_of(level.entity_count, 0);
+    std::vector<int> group_chunks;
+    std::map<int, std::uint32_t> chunk_groups;
+
+    for (std::uint32_t i = 0; i < level.entity_count; ++i) {
+        const entity_bounds& entity = bounds[i];
+        if (entity.player || (!entity.collides && !entity.positioned)) continue;
+
+        double left = entity.collides ? entity.hitbox.x : entity.x;
+        double right = entity.collides ? left + entity.hitbox.w : left + entity.width;
+        int first = chunk_of(left);
+        int last = chunk_of(right);
+
+        if (active.overlaps(first, last)) {
+            live_chunks.push_back(first);
+            continue;
+        }
+
+        auto [found, added] = chunk_groups.emplace(first, static_cast<std::uint32_t>(group_chunks.size() + 1));
+        if (added) group_chunks.push_back(first);
+        group_of[i] = found->second;
+
+        chunk& target = chunks[first];
+        if (target.state == chunk_state::UNLOADED && !load(first, target)) {
+            target.state = chunk_state::LOADED;
+        }
+        target.reach = target.entity_count == 0 ? last : std::max(target.reach, last);
+        target.entity_count++;
+    }
+
+    std::vector<std::vector<unsigned char>> blobs(group_chunks.size() + 1);
+    split_cooked(level, group_of, blobs);
+
+    size_t created = 0;
+    std::string error;
+    if (!load_cooked(em, blobs[0].data(), blobs[0].size(), created, error)) {
+        LOG_ERROR("Could not create the active chunks, {}", error);
+    }
+
+    for (size_t group = 1; group < blobs.size(); ++group) {
+        chunks[group_chunks[group - 1]].blobs.push_back(std::move(blobs[group]));
+    }
+    blobs.clear();
+
+    spill(ranges_around(settings.loaded_radius));
+
+    updates_since_scan = 0;
+    ++generation_count;
+    count_chunks();
+    return true;
+}
+
+int World_Streamer::chunk_of(double x) const {
+    return static_cast<int>(std::floor(x / settings.chunk_width));
+}
+
+chunk_state World_Streamer::state(int index) const {
+    auto found = chunks.find(index);
+    return found == chunks.end() ? chunk_state::ACTIVE : found->second.state;
+}
+
+World_Streamer::chunk_ranges World_Streamer::ranges_around(int radius) const {
+    chunk_ranges result;
+    for (int player : player_chunks) {
+        if (!result.ranges.empty() && player - radius <= result.ranges.back().second + 1) {
+            result.ranges.back().second = player + radius;
+        }
+        else {
+            result.ranges.emplace_back(player - radius, player + radius);
+        }
+    }
+    return result;
+}
+
+bool World_Streamer::update() {
+    if (!settings.enabled) return false;
+
+    auto start = std::chrono::steady_clock::now();
+    last_stats.activations = 0;
+    last_stats.deactivations = 0;
+
+    std::vector<int> current_chunks;
+    for (auto [id, position, key_binds] : em.view<components::position, components::input>()) {
+        current_chunks.push_back(chunk_of(position.pos.x));
+    }
+    if (current_chunks.empty()) return false;
+
+    std::sort(current_chunks.begin(), current_chunks.end());
+    current_chunks.erase(std::unique(current_chunks.begin(), current_chunks.end()), current_chunks.end());
+
+    //nothing to do until a player changes chunk, besides looking for strays now and then
+    ++updates_since_scan;
+    if (current_chunks == player_chunks && updates_since_scan < settings.scan_interval) return false;
+
+    updates_since_scan = 0;
+    player_chunks = std::move(current_chunks);
+
+    chunk_ranges active = ranges_around(settings.active_radius);
+    chunk_ranges resident = ranges_around(settings.loaded_radius);
+    bool changed = false;
+
+    for (auto it = chunks.begin(); it != chunks.end();) {
+        if (active.overlaps(it->first, it->second.reach)) {
+            activate(it->first, it->second);
+            it = chunks.erase(it);
+            changed = true;
+        }
+        else {
+            ++it;
+        }
+    }
+
+    changed = deactivate_out_of_range(active) || changed;
+
+    spill(resident);
+
+    if (changed) ++generation_count;
+    count_chunks();
+
+    last_stats.last_update_ms = milliseconds_since(start);
+    return changed;
+}
+
+void World_Streamer::spill(const chunk_ranges& resident) {
+    for (auto it = chunks.begin(); it != chunks.end();) {
+        bool near = resident.overlaps(it->first, it->second.reach);
+        bool ok = true;
+
+        if (it->second.state == chunk_state::LOADED && !near) ok = unload(it->first, it->second);
+        else if (it->second.state == chunk_state::UNLOADED && near) ok = load(it->first, it->second);
+
+        //a chunk that can't be read back is lost, dropping it avoids retrying every scan
+        if (!ok && it->second.state == chunk_state::UNLOADED) it = chunks.erase(it);
+        else ++it;
+    }
+}
+
+bool World_Streamer::entity_chunks(entity_handle id, int& first, int& last) {
+    double left = 0.0;
+    double right = 0.0;
+
+    if (auto* collision = em.get_component<components::collision>(id)) {
+        left = collision->hitbox.x;
+        right = left + collision->hitbox.w;
+    }
+    else if (auto* position = em.get_component<components::position>(id)) {
+        auto* render = em.get_component<components::render>(id);
+        left = position->pos.x;
+        right = left + (render ? render->sprite_rect.w : 0.0f);
+    }
+    else {
+        return false;
+    }
+
+    first = chunk_of(left);
+    last = chunk_of(right);
+    return true;
+}
+
+void World_Streamer::activate(int index, chunk& target) {
+    auto start = std::chrono::steady_clock::now();
+
+    if (target.state == chunk_state::UNLOADED && !load(index, target)) return;
+
+    for (auto& blob : target.blobs) {
+        size_t created = 0;
+        std::string error;
+        if (!load_cooked(em, blob.data(), blob.size(), created, error)) {
+            LOG_ERROR("Could not restore chunk {}, {}", index, error);
+        }
+    }
+
+    last_stats.activations++;
+    last_stats.last_activation_ms = milliseconds_since(start);
+    last_stats.max_activation_ms = std::max(last_stats.max_activation_ms, last_stats.last_activation_ms);
+}
+
+bool World_Streamer::deactivate_out_of_range(const chunk_ranges& active) {
+    leaving.clear();
+    leaving_by_chunk.clear();
+    live_chunks.clear();
+
+    auto consider = [&](entity_handle id) {
+        int first = 0;
+        int last = 0;
+        if (!entity_chunks(id, first, last)) return;
+
+        if (active.overlaps(first, last)) {
+            live_chunks.push_back(first);
+            return;
+        }
+
+        leaving.push_back(id);
+        leaving_by_chunk[first].push_back(id);
+    };
+
+    for (auto [id, collision] : em.view<components::collision, query::exclude<components::input>>()) {
+        consider(id);
+    }
+    for (auto [id, position] : em.view<components::position, query::exclude<components::collision>, query::exclude<components::input>>()) {
+        consider(id);
+    }
+
+    for (auto& [index, ids] : leaving_by_chunk) {
+        chunk& target = chunks[index];
+        if (target.state == chunk_state::UNLOADED && !load(index, target)) {
+            target.state = chunk_state::LOADED; //start over in memory, the file is lost anyway
+        }
+
+        for (entity_handle id : ids) {
+            int first = 0;
+            int last = 0;
+            entity_chunks(id, first, last);
+            target.reach = target.entity_count == 0 ? last : std::max(target.reach, last);
+        }
+
+        target.blobs.emplace_back();
+        cook_entities(em, ids, target.blobs.back());
+        target.entity_count += ids.size();
+        last_stats.deactivations++;
+    }
+
+    //deleted only once every chunk is cooked, views don't like entities vanishing under them
+    for (entity_handle id : leaving) {
+        em.delete_entity(id);
+    }
+
+    return !leaving.empty();
+}
+
+bool World_Streamer::unload(int index, chunk& target) {
+    if (chunk_directory().empty()) return false;
+
+    std::ofstream file(chunk_path(index), std::ios::binary | std::ios::trunc);
+
+    //blob count, then the size and bytes of every blob
+    std::uint32_t blob_count = static_cast<std::uint32_t>(target.blobs.size());
+    file.write(reinterpret_cast<const char*>(&blob_count), sizeof(blob_count));
+    for (auto& blob : target.blobs) {
+        std::uint64_t size = blob.size();
+        file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        file.write(reinterpret_cast<const char*>(blob.data()), static_cast<std::streamsize>(blob.size()));
+    }
+
+    if (!file) {
+        LOG_WARN("Could not write chunk {} to {}, keeping it in memory", index, chunk_path(index));
+        return false;
+    }
+
+    target.blobs.clear();
+    target.blobs.shrink_to_fit();
+    target.state = chunk_state::UNLOADED;
+    return true;
+}
+
+bool World_Streamer::load(int index, chunk& target) {
+    std::ifstream file(chunk_path(index), std::ios::binary);
+
+    std::uint32_t blob_count = 0;
+    file.read(reinterpret_cast<char*>(&blob_count), sizeof(blob_count));
+
+    std::vector<std::vector<unsigned char>> blobs(file ? blob_count : 0);
+    for (auto& blob : blobs) {
+        std::uint64_t size = 0;
+        file.read(reinterpret_cast<char*>(&size), sizeof(size));
+        if (!file) break;
+
+        blob.resize(static_cast<size_t>(size));
+        file.read(reinterpret_cast<char*>(blob.data()), static_cast<std::streamsize>(size));
+    }
+
+    if (!file) {
+        LOG_ERROR("Could not read chunk {} from {}", index, chunk_path(index));
+        return false;
+    }
+
+    target.blobs = std::move(blobs);
+    target.state = chunk_state::LOADED;
+    return true;
+}
+
+const std::string& World_Streamer::chunk_directory() {
+    if (!directory.empty() || directory_failed) return directory;
+
+    if (!settings.directory.empty()) {
+        directory = settings.directory;
+        return directory;
+    }
+
+    //a directory of our own, so two games running at once don't overwrite each other's chunks
+    std::error_code error;
+    std::filesystem::path temp = std::filesystem::temp_directory_path(error);
+    std::random_device random;
+    for (int attempt = 0; !error && attempt < 16; ++attempt) {
+        std::filesystem::path candidate = temp / ("platforming_game_chunks_" + std::to_string(random()));
+        if (std::filesystem::create_directory(candidate, error)) {
+            directory = candidate.string();
+            owns_directory = true;
+            break;
+        }
+    }
+
+    if (directory.empty()) {
+        LOG_WARN("Could not create a temporary chunk directory, far chunks stay in memory");
+        directory_failed = true;
+    }
+    return directory;
+}
+
+std::string World_Streamer::chunk_path(int index) {
+    return chunk_directory() + "/chunk_" + std::to_string(index) + ".bin";
+}
+
+void World_Streamer::count_chunks() {
+    std::sort(live_chunks.begin(), live_chunks.end());
+    last_stats.active_chunks = static_cast<size_t>(std::unique(live_chunks.begin(), live_chunks.end()) - live_chunks.begin());
+
+    last_stats.loaded_chunks = 0;
+    last_stats.unloaded_chunks = 0;
+    last_stats.resident_bytes = 0;
+    last_stats.streamed_entities = 0;
+
+    for (auto& [index, inactive] : chunks) {
+        if (inactive.state == chunk_state::LOADED) last_stats.loaded_chunks++;
+        else last_stats.unloaded_chunks++;
+
+        for (auto& blob : inactive.blobs) {
+            last_stats.resident_bytes += blob.size();
+        }
+        last_stats.streamed_entities += inactive.entity_count;
+    }
+}
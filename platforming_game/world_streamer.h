@@ -0,0 +1,116 @@
+#pragma once
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "entity.h"
+#include "level.h"
+
+//the level is cut along x into chunks chunk_width pixels wide. chunks close to a player keep their
+//entities in the entity_manager, the others are serialized into blobs (the cooked level format of
+//level.h) and their entities deleted, so the simulation and the renderer only ever see the
+//neighbourhood of the players however long the level is. levels are split the same way when they
+//are loaded, so the far chunks are never instantiated. memory stays bounded by default: only the
+//chunks within loaded_radius of a player are resident, the rest live on disk
+enum class chunk_state {
+    ACTIVE, //its entities are live
+    LOADED, //serialized into blobs in memory
+    UNLOADED //serialized into a file in the chunk directory, nothing in memory
+};
+
+struct streaming_settings {
+    bool enabled = true;
+    double chunk_width = 2048.0;
+    int active_radius = 1; //chunks at most this far from a player's chunk are active
+    int loaded_radius = 3; //inactive chunks up to this far stay in memory, farther ones are written to disk
+    int scan_interval = 30; //updates between looks for entities that walked out of the active chunks
+    std::string directory; //where unloaded chunks go, empty uses a temporary directory removed with the streamer
+};
+
+struct streaming_stats {
+    size_t active_chunks = 0; //chunks holding live entities, as of the last scan
+    size_t loaded_chunks = 0;
+    size_t unloaded_chunks = 0;
+    size_t resident_bytes = 0; //blob memory of the loaded chunks
+    size_t streamed_entities = 0; //entities serialized in loaded or unloaded chunks
+    int activations = 0; //chunks activated by the last update
+    int deactivations = 0; //chunks that received entities in the last update
+    double last_activation_ms = 0.0; //from blob (or file) to live entities, for the last chunk activated
+    double max_activation_ms = 0.0;
+    double last_update_ms = 0.0;
+};
+
+//streams chunks in and out around every entity with an input and a position component, those
+//entities are never streamed out. an entity belongs to the chunk its hitbox (or position) starts in
+//and is only streamed out once none of the chunks it covers is active. components outside the
+//level schema (asleep...) are dropped when an entity is serialized, its timers are started again by
+//the component hooks when it is restored
+class World_Streamer {
+public:
+    World_Streamer(entity_manager& em, streaming_settings settings = streaming_settings());
+    ~World_Streamer();
+
+    World_Streamer(const World_Streamer&) = delete;
+    World_Streamer& operator=(const World_Streamer&) = delete;
+
+    //loads a text or cooked level file with only the chunks around its players live, the others are
+    //cooked straight into chunk blobs and the ones past loaded_radius written to disk. everything is
+    //live when streaming is disabled or the level has no player. loading briefly holds the level twice
+    bool load_level(const std::string& path, size_t& entity_count, Tilemap* tilemap = nullptr);
+
+    //true when entities were created or deleted, static indices over the level have to be rebuilt
+    bool update();
+
+    int chunk_of(double x) const;
+    chunk_state state(int chunk) const;
+
+    //incremented by every update that created or deleted entities
+    unsigned long long generation() const {
+        return generation_count;
+    }
+
+    const streaming_stats& stats() const {
+        return last_stats;
+    }
+
+private:
+    //disjoint, sorted chunk ranges
+    struct chunk_ranges {
+        std::vector<std::pair<int, int>> ranges;
+        bool overlaps(int first, int last) const;
+    };
+
+    struct chunk {
+        chunk_state state = chunk_state::LOADED;
+        int reach = 0; //last chunk covered by one of its entities
+        std::vector<std::vector<unsigned char>> blobs; //one per deactivation that added entities
+        size_t entity_count = 0;
+    };
+
+    chunk_ranges ranges_around(int radius) const;
+    bool split_level(const cooked_level& level);
+    void spill(const chunk_ranges& resident);
+    bool entity_chunks(entity_handle id, int& first, int& last);
+    void activate(int index, chunk& target);
+    bool deactivate_out_of_range(const chunk_ranges& active);
+    bool unload(int index, chunk& target);
+    bool load(int index, chunk& target);
+    std::string chunk_path(int index);
+    const std::string& chunk_directory();
+    void count_chunks();
+
+    entity_manager& em;
+    streaming_settings settings;
+    std::string directory; //settings.directory or a temporary one, set by the first unload
+    bool owns_directory = false;
+    bool directory_failed = false; //no temporary directory could be made, chunks stay in memory
+    std::map<int, chunk> chunks; //inactive chunks only, a chunk missing from the map is active
+    std::vector<int> player_chunks;
+    int updates_since_scan = 0;
+    unsigned long long generation_count = 0;
+    streaming_stats last_stats;
+
+    std::vector<entity_handle> leaving; //gathered by the deactivation scan
+    std::map<int, std::vector<entity_handle>> leaving_by_chunk;
+    std::vector<int> live_chunks; //first chunk of every live entity seen by the last scan
+};
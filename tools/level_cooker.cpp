@@ -0,0 +1,18 @@
+//cooks a text level into the binary form the game memory maps, see level.h.
+//usage: level_cooker levels/level1.txt levels/level1.lvlb
+#include <iostream>
+#include "level.h"
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "usage: " << argv[0] << " <level.txt> <level.lvlb>\n";
+        return 1;
+    }
+
+    level_data level;
+    if (!read_level_text(argv[1], level)) return 1;
+    if (!cook_level(level, argv[2])) return 1;
+
+    std::cout << "Cooked " << level.entities.size() << " entities into " << argv[2] << "\n";
+    return 0;
+}